@@ -0,0 +1,25 @@
+#pragma once
+
+#include "defines.h"
+
+#include <stdio.h>
+#include <time.h>
+
+// Written with every result the benchmarks compute so the compiler can not drop the measured work.
+extern volatile u64 benchmark_sink;
+
+// Wall clock time in nanoseconds, only meaningful as the difference of two calls.
+static inline u64 benchmark_time_ns() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+}
+
+// Prints the average time per operation of a finished run.
+static inline void benchmark_report(const char* name, u64 operations, u64 elapsed_ns) {
+    printf("  %-48s %10.2f ns/op\n", name, (f64)elapsed_ns / (f64)operations);
+}
+
+void darray_benchmarks();
+void darray_define_benchmarks();
+void memory_benchmarks();
@@ -0,0 +1,137 @@
+#include "benchmark.h"
+
+#include "utils/darray.h"
+
+#define ELEMENT_COUNT 4096
+#define ROUNDS 256
+
+static u32 values[ELEMENT_COUNT];
+
+// Pushing one element at a time grows the array log2(n) times, push_n grows it once.
+static void bench_push_n() {
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u32* array = darray_create(u32, MEMORY_TAG_CORE);
+        for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+            darray_push(array, values[i]);
+
+        benchmark_sink += darray_length(array);
+        darray_destroy(array);
+    }
+    benchmark_report("darray_push loop", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u32* array = darray_create(u32, MEMORY_TAG_CORE);
+        darray_push_n(array, values, ELEMENT_COUNT);
+
+        benchmark_sink += darray_length(array);
+        darray_destroy(array);
+    }
+    benchmark_report("darray_push_n", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+}
+
+static void bench_append_array() {
+    u32* other = darray_reserve(u32, ELEMENT_COUNT, MEMORY_TAG_CORE);
+    darray_push_n(other, values, ELEMENT_COUNT);
+
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u32* array = darray_create(u32, MEMORY_TAG_CORE);
+        u64 length = darray_length(other);
+        for (u64 i = 0; i < length; ++i)
+            darray_push(array, other[i]);
+
+        benchmark_sink += darray_length(array);
+        darray_destroy(array);
+    }
+    benchmark_report("darray_push loop over another darray", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u32* array = darray_create(u32, MEMORY_TAG_CORE);
+        darray_append_array(array, other);
+
+        benchmark_sink += darray_length(array);
+        darray_destroy(array);
+    }
+    benchmark_report("darray_append_array", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    darray_destroy(other);
+}
+
+// Empties the array from the front, pop_at shifts every remaining element, swap_remove moves one.
+static void bench_swap_remove() {
+    u32* array = darray_reserve(u32, ELEMENT_COUNT, MEMORY_TAG_CORE);
+
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        darray_push_n(array, values, ELEMENT_COUNT);
+
+        u32 value = 0;
+        while (darray_length(array) > 0) {
+            darray_pop_at(array, 0, &value);
+            benchmark_sink += value;
+        }
+    }
+    benchmark_report("darray_pop_at front", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        darray_push_n(array, values, ELEMENT_COUNT);
+
+        u32 value = 0;
+        while (darray_length(array) > 0) {
+            darray_swap_remove(array, 0, &value);
+            benchmark_sink += value;
+        }
+    }
+    benchmark_report("darray_swap_remove front", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    darray_destroy(array);
+}
+
+// Removes the middle half of the array, once element by element and once as a single range.
+static void bench_erase_range() {
+    u32* array = darray_reserve(u32, ELEMENT_COUNT, MEMORY_TAG_CORE);
+    const u64 index = ELEMENT_COUNT / 4;
+    const u64 count = ELEMENT_COUNT / 2;
+
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        darray_push_n(array, values, ELEMENT_COUNT);
+
+        for (u64 i = 0; i < count; ++i)
+            darray_pop_at(array, index, NULL);
+
+        benchmark_sink += array[index];
+    }
+    benchmark_report("darray_pop_at loop over a range", (u64)ROUNDS * count, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        darray_push_n(array, values, ELEMENT_COUNT);
+
+        darray_erase_range(array, index, count);
+
+        benchmark_sink += array[index];
+    }
+    benchmark_report("darray_erase_range", (u64)ROUNDS * count, benchmark_time_ns() - start);
+
+    darray_destroy(array);
+}
+
+void darray_benchmarks() {
+    for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+        values[i] = i;
+
+    printf("darray bulk operations, %u u32 elements:\n", ELEMENT_COUNT);
+    bench_push_n();
+    bench_append_array();
+    bench_swap_remove();
+    bench_erase_range();
+}
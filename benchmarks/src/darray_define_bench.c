@@ -0,0 +1,85 @@
+#include "benchmark.h"
+
+#include "utils/darray.h"
+
+#define ELEMENT_COUNT 4096
+#define ROUNDS 1024
+
+DARRAY_DEFINE(u32)
+
+// The generic path, an out of line push copying 'stride' bytes and the length read through _darray_field_get.
+static void bench_generic() {
+    u32* array = darray_create(u32, MEMORY_TAG_CORE);
+
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+            darray_push(array, i);
+    }
+    benchmark_report("darray_push", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u64 sum = 0;
+        for (u64 i = 0; i < _darray_field_get(array, DARRAY_LENGTH); ++i)
+            sum += array[i];
+
+        benchmark_sink += sum;
+    }
+    benchmark_report("iterate with _darray_field_get length", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_length_set(array, ELEMENT_COUNT);
+
+        u32 value = 0;
+        while (_darray_field_get(array, DARRAY_LENGTH) > 0) {
+            darray_pop(array, &value);
+            benchmark_sink += value;
+        }
+    }
+    benchmark_report("darray_pop", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    darray_destroy(array);
+}
+
+// The same work through the helpers generated by DARRAY_DEFINE and the inline header accessors.
+static void bench_defined() {
+    u32* array = darray_u32_create(MEMORY_TAG_CORE);
+
+    u64 start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_clear(array);
+        for (u32 i = 0; i < ELEMENT_COUNT; ++i)
+            array = darray_u32_push(array, i);
+    }
+    benchmark_report("darray_u32_push", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        u64 sum = 0;
+        for (u64 i = 0; i < darray_length(array); ++i)
+            sum += array[i];
+
+        benchmark_sink += sum;
+    }
+    benchmark_report("iterate with inline darray_length", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    start = benchmark_time_ns();
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        darray_length_set(array, ELEMENT_COUNT);
+
+        while (darray_length(array) > 0)
+            benchmark_sink += darray_u32_pop(array);
+    }
+    benchmark_report("darray_u32_pop", (u64)ROUNDS * ELEMENT_COUNT, benchmark_time_ns() - start);
+
+    darray_destroy(array);
+}
+
+void darray_define_benchmarks() {
+    printf("darray generic versus DARRAY_DEFINE(u32), %u elements:\n", ELEMENT_COUNT);
+    bench_generic();
+    bench_defined();
+}
@@ -0,0 +1,19 @@
+#include "benchmark.h"
+
+#include "core/memory.h"
+
+volatile u64 benchmark_sink;
+
+int main() {
+    memory_config config = memory_default_config();
+    if (!memory_init(&config)) return 1;
+
+    darray_benchmarks();
+    darray_define_benchmarks();
+
+    memory_shutdown();
+
+    // Initializes the memory system again for every configuration it compares.
+    memory_benchmarks();
+    return 0;
+}
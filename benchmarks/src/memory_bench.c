@@ -0,0 +1,99 @@
+#include "benchmark.h"
+
+#include "core/memory.h"
+#include "platform/platform.h"
+#include "platform/threading.h"
+
+#define SLOT_COUNT 256
+#define OPERATIONS_PER_THREAD (1 << 20)
+#define MAX_THREADS 64
+
+// Randomly allocates into empty slots and frees full ones, the churn of small
+// short lived allocations thread caches are meant to absorb.
+static b8 churn(void* arg) {
+    void* blocks[SLOT_COUNT] = { 0 };
+    u64 sizes[SLOT_COUNT] = { 0 };
+    u32 seed = (u32)(u64)arg * 2654435761u + 1;
+
+    for (u32 i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        u32 slot = (seed >> 8) % SLOT_COUNT;
+
+        if (blocks[slot]) {
+            bfree(blocks[slot], sizes[slot], MEMORY_TAG_CORE);
+            blocks[slot] = NULL;
+        }
+        else {
+            sizes[slot] = 16 + (seed >> 20) % 497;
+            blocks[slot] = ballocate(sizes[slot], MEMORY_TAG_CORE);
+            if (!blocks[slot]) return FALSE;
+        }
+    }
+
+    for (u32 slot = 0; slot < SLOT_COUNT; ++slot) {
+        if (blocks[slot]) bfree(blocks[slot], sizes[slot], MEMORY_TAG_CORE);
+    }
+
+    memory_thread_shutdown();
+    return TRUE;
+}
+
+// Runs 'thread_count' threads churning at the same time, returns the number that actually started.
+static u32 run_threads(u32 thread_count, u64* out_elapsed_ns) {
+    box_thread threads[MAX_THREADS];
+    u64 start = benchmark_time_ns();
+
+    u32 started = 0;
+    for (; started < thread_count; ++started) {
+        if (!thread_create(&threads[started], churn, (void*)(u64)(started + 1))) break;
+    }
+
+    b8 failed = FALSE;
+    for (u32 i = 0; i < started; ++i) {
+        int result = 0;
+        thread_join(threads[i], &result);
+        failed |= !result;
+    }
+
+    *out_elapsed_ns = benchmark_time_ns() - start;
+    if (failed) printf("  Allocation failed\n");
+    return started;
+}
+
+// Scales from 1 thread up to one per processor, doubling each step.
+static void bench_churn(b8 enable_thread_cache, u32 max_threads) {
+    memory_config config = memory_default_config();
+    config.enable_thread_cache = enable_thread_cache;
+    if (!memory_init(&config)) return;
+
+    for (u32 thread_count = 1;; thread_count = BX_MIN(thread_count * 2, max_threads)) {
+        u64 elapsed = 0;
+        u32 started = run_threads(thread_count, &elapsed);
+        if (started == 0) {
+            printf("  Failed to start any thread\n");
+            break;
+        }
+
+        // Wall time over every operation of every thread, lower means more throughput.
+        char name[64];
+        snprintf(name, sizeof(name), "%u thread%s, %s", started, started == 1 ? "" : "s",
+            enable_thread_cache ? "thread cache" : "no thread cache");
+        benchmark_report(name, (u64)started * OPERATIONS_PER_THREAD, elapsed);
+
+        if (started < thread_count) {
+            printf("  Only %u of %u threads started\n", started, thread_count);
+            break;
+        }
+
+        if (thread_count == max_threads) break;
+    }
+
+    memory_shutdown();
+}
+
+void memory_benchmarks() {
+    u32 max_threads = BX_MIN(platform_get_processor_count(), MAX_THREADS);
+    printf("ballocate / bfree churn, 16 to 512 bytes, 1 to %u threads:\n", max_threads);
+    bench_churn(FALSE, max_threads);
+    bench_churn(TRUE, max_threads);
+}
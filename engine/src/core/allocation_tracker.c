@@ -0,0 +1,233 @@
+#include "defines.h"
+#include "allocation_tracker.h"
+
+#if BOX_ENABLE_DIAGNOSTICS
+
+#include "platform/platform.h"
+#include "platform/threading.h"
+#include "platform/filesystem.h"
+
+#include "utils/string_utils.h"
+
+// Live block, keyed by address in an open-addressing table with linear probing.
+typedef struct tracked_block {
+	const void* block;
+	u64 size;
+	u32 site;
+} tracked_block;
+
+typedef struct allocation_tracker_state {
+	// Call sites, keyed by file and line. The last entry collects sites that did not fit.
+	allocation_site sites[ALLOCATION_TRACKER_MAX_SITES + 1];
+	u32 site_count;
+
+	// Power of two sized table of live blocks, grown once it is half full.
+	tracked_block* blocks;
+	u64 block_capacity;
+	u64 block_count;
+
+	box_mutex lock;
+} allocation_tracker_state;
+
+// Tables come straight from the platform so tracking never records itself.
+static allocation_tracker_state* state = NULL;
+
+static inline u64 hash_pointer(const void* ptr) {
+	u64 x = (u64)ptr;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	return x;
+}
+
+static u32 find_site(const char* file, u32 line, memory_tag tag) {
+	u64 mask = ALLOCATION_TRACKER_MAX_SITES - 1;
+	u64 index = (hash_pointer(file) ^ (line * 0x9e3779b97f4a7c15ULL)) & mask;
+
+	for (u32 probe = 0; probe < ALLOCATION_TRACKER_MAX_SITES; ++probe) {
+		allocation_site* site = &state->sites[index];
+		if (site->file == file && site->line == line) return (u32)index;
+
+		if (site->file == NULL) {
+			site->file = file;
+			site->line = line;
+			site->tag = tag;
+			state->site_count++;
+			return (u32)index;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	return ALLOCATION_TRACKER_MAX_SITES;
+}
+
+static void insert_block(tracked_block* blocks, u64 capacity, tracked_block* entry) {
+	u64 mask = capacity - 1;
+	u64 index = hash_pointer(entry->block) & mask;
+	while (blocks[index].block != NULL)
+		index = (index + 1) & mask;
+
+	blocks[index] = *entry;
+}
+
+static b8 grow_blocks() {
+	u64 new_capacity = state->block_capacity * 2;
+	tracked_block* new_blocks = platform_allocate(new_capacity * sizeof(tracked_block), FALSE);
+	if (!new_blocks) return FALSE;
+
+	platform_set_memory(new_blocks, 0, new_capacity * sizeof(tracked_block));
+	for (u64 i = 0; i < state->block_capacity; ++i) {
+		if (state->blocks[i].block == NULL) continue;
+		insert_block(new_blocks, new_capacity, &state->blocks[i]);
+	}
+
+	platform_free(state->blocks, FALSE);
+	state->blocks = new_blocks;
+	state->block_capacity = new_capacity;
+	return TRUE;
+}
+
+b8 allocation_tracker_init() {
+	BX_ASSERT(state == NULL && "Allocation tracker initialized twice");
+
+	state = platform_allocate(sizeof(allocation_tracker_state), FALSE);
+	if (!state) return FALSE;
+	platform_set_memory(state, 0, sizeof(allocation_tracker_state));
+
+	state->block_capacity = 1024;
+	state->blocks = platform_allocate(state->block_capacity * sizeof(tracked_block), FALSE);
+	if (!state->blocks || !mutex_init(&state->lock, BOX_MUTEX_TYPE_PLAIN)) {
+		if (state->blocks) platform_free(state->blocks, FALSE);
+		platform_free(state, FALSE);
+		state = NULL;
+		return FALSE;
+	}
+
+	platform_set_memory(state->blocks, 0, state->block_capacity * sizeof(tracked_block));
+	state->sites[ALLOCATION_TRACKER_MAX_SITES].file = "<untracked sites>";
+	return TRUE;
+}
+
+void allocation_tracker_shutdown() {
+	if (!state) return;
+
+	mutex_destroy(&state->lock);
+	platform_free(state->blocks, FALSE);
+	platform_free(state, FALSE);
+	state = NULL;
+}
+
+void allocation_tracker_record(const void* block, u64 size, memory_tag tag, const char* file, u32 line) {
+	if (!state || !block) return;
+
+	mutex_lock(&state->lock);
+
+	u32 index = find_site(file ? file : "<unknown>", line, tag);
+	allocation_site* site = &state->sites[index];
+	site->total_bytes += size;
+	site->total_count++;
+	site->live_bytes += size;
+	site->live_count++;
+
+	if ((state->block_count + 1) * 2 > state->block_capacity && !grow_blocks()) {
+		BX_WARN("Allocation tracker ran out of memory, block at %p will not be tracked", block);
+	}
+	else {
+		tracked_block entry = { block, size, index };
+		insert_block(state->blocks, state->block_capacity, &entry);
+		state->block_count++;
+	}
+
+	mutex_unlock(&state->lock);
+}
+
+void allocation_tracker_remove(const void* block) {
+	if (!state || !block) return;
+
+	mutex_lock(&state->lock);
+
+	u64 mask = state->block_capacity - 1;
+	u64 index = hash_pointer(block) & mask;
+	while (state->blocks[index].block != NULL && state->blocks[index].block != block)
+		index = (index + 1) & mask;
+
+	if (state->blocks[index].block == NULL) {
+		mutex_unlock(&state->lock);
+		return;
+	}
+
+	allocation_site* site = &state->sites[state->blocks[index].site];
+	site->live_bytes -= state->blocks[index].size;
+	site->live_count--;
+
+	// Backward shift deletion, pulls later entries of the probe chain into the hole so no tombstones are needed.
+	u64 hole = index;
+	for (u64 next = (hole + 1) & mask; state->blocks[next].block != NULL; next = (next + 1) & mask) {
+		u64 home = hash_pointer(state->blocks[next].block) & mask;
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			state->blocks[hole] = state->blocks[next];
+			hole = next;
+		}
+	}
+
+	state->blocks[hole].block = NULL;
+	state->block_count--;
+
+	mutex_unlock(&state->lock);
+}
+
+u32 allocation_tracker_dump(b8 live_only, const char* path) {
+	if (!state) return 0;
+
+	mutex_lock(&state->lock);
+
+	// Copy the used sites out so the report does not hold the lock while logging.
+	u32 count = 0;
+	allocation_site* sorted = platform_allocate(sizeof(allocation_site) * (state->site_count + 1), FALSE);
+	for (u32 i = 0; i < ALLOCATION_TRACKER_MAX_SITES + 1; ++i) {
+		allocation_site* site = &state->sites[i];
+		if (site->total_count == 0 || (live_only && site->live_count == 0)) continue;
+		sorted[count++] = *site;
+	}
+
+	mutex_unlock(&state->lock);
+
+	// Insertion sort, the number of distinct sites stays small.
+	for (u32 i = 1; i < count; ++i) {
+		allocation_site key = sorted[i];
+		u64 key_bytes = live_only ? key.live_bytes : key.total_bytes;
+
+		u32 j = i;
+		for (; j > 0 && (live_only ? sorted[j - 1].live_bytes : sorted[j - 1].total_bytes) < key_bytes; --j)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = key;
+	}
+
+	file_handle file = {};
+	if (path && !filesystem_open(path, FILE_MODE_WRITE, FALSE, &file)) {
+		BX_ERROR("Failed to open '%s' to write allocation sites", path);
+	}
+
+	BX_TRACE("Allocation sites (%s):", live_only ? "live" : "total");
+	for (u32 i = 0; i < count; ++i) {
+		allocation_site* site = &sorted[i];
+		u64 bytes = live_only ? site->live_bytes : site->total_bytes;
+		u64 allocations = live_only ? site->live_count : site->total_count;
+
+		BX_TRACE("  %s:%u | %llu bytes in %llu allocations (%s)", site->file, site->line, bytes, allocations, memory_tag_name(site->tag));
+
+		if (file.is_valid) {
+			char* line = string_format("%s;%s:%u %llu", memory_tag_name(site->tag), site->file, site->line, bytes);
+			filesystem_write_line(&file, line);
+			platform_free(line, FALSE);
+		}
+	}
+
+	if (file.is_valid) filesystem_close(&file);
+
+	platform_free(sorted, FALSE);
+	return count;
+}
+
+#endif
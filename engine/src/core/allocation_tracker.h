@@ -0,0 +1,39 @@
+#pragma once
+
+#include "defines.h"
+
+#include "memory.h"
+
+// Number of distinct call sites the tracker can tell apart, further sites are folded into an overflow entry.
+#define ALLOCATION_TRACKER_MAX_SITES 4096
+
+// Allocation statistics of a single ballocate call site.
+typedef struct allocation_site {
+	const char* file;
+	u32 line;
+	memory_tag tag;
+
+	// Bytes and allocations made from this site since tracking started.
+	u64 total_bytes;
+	u64 total_count;
+
+	// Bytes and allocations from this site that have not been freed yet.
+	u64 live_bytes;
+	u64 live_count;
+} allocation_site;
+
+// Starts recording call sites, only available when BOX_ENABLE_DIAGNOSTICS is set.
+b8 allocation_tracker_init();
+
+void allocation_tracker_shutdown();
+
+// Records an allocation of 'size' bytes at 'block' made from 'file':'line'.
+void allocation_tracker_record(const void* block, u64 size, memory_tag tag, const char* file, u32 line);
+
+// Removes a block from the live set, unknown blocks (made before tracking started) are ignored.
+void allocation_tracker_remove(const void* block);
+
+// Logs every site sorted by volume, by live bytes if 'live_only' is set or by total bytes otherwise.
+// If 'path' is not NULL the same report is written there as folded stacks ("TAG;file:line bytes")
+// that flamegraph tools accept directly. Returns the number of sites reported.
+u32 allocation_tracker_dump(b8 live_only, const char* path);
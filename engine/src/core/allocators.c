@@ -5,27 +5,34 @@
 #include "utils/darray.h"
 
 void burst_add_block(burst_allocator* allocator, u64 size, memory_tag tag, void** out_pointer) {
-	BX_ASSERT(allocator != NULL && size > 0 && tag < MEMORY_TAG_MAX_TAGS && out_pointer != NULL && "Invalid arguments passed to burst_add_block");
+	burst_add_block_aligned(allocator, size, 8ULL, tag, out_pointer);
+}
+
+void burst_add_block_aligned(burst_allocator* allocator, u64 size, u64 block_alignment, memory_tag tag, void** out_pointer) {
+	BX_ASSERT(allocator != NULL && size > 0 && (block_alignment & (block_alignment - 1)) == 0 && tag < MEMORY_TAG_MAX_TAGS && out_pointer != NULL && "Invalid arguments passed to burst_add_block");
 	if (!allocator->entries)
 		allocator->entries = darray_create(burst_allocator_entry, MEMORY_TAG_CORE);
 
 	burst_allocator_entry* entry = darray_push_empty(allocator->entries);
 	entry->out_pointer = out_pointer;
 	entry->size = size;
+	entry->alignment = BX_MAX(block_alignment, 8ULL);
 	entry->tag = tag;
 
-	allocator->total_size += size;
+	allocator->total_size = alignment(allocator->total_size, entry->alignment) + size;
+	allocator->max_alignment = BX_MAX(allocator->max_alignment, entry->alignment);
 }
 
 void* burst_allocate_all(burst_allocator* allocator) {
 	BX_ASSERT(allocator != NULL && "Invalid arguments passed to burst_allocate_all");
-	allocator->allocated_block = platform_allocate(allocator->total_size, FALSE);
+	allocator->allocated_block = platform_allocate_aligned(allocator->total_size, allocator->max_alignment);
 	platform_set_memory(allocator->allocated_block, 0, allocator->total_size);
 
 	u64 offset = 0;
 
 	for (u32 i = 0; i < darray_length(allocator->entries); ++i) {
 		burst_allocator_entry* entry = &allocator->entries[i];
+		offset = alignment(offset, entry->alignment);
 		*entry->out_pointer = (u8*)allocator->allocated_block + offset;
 
 		breport(entry->size, entry->tag);
@@ -42,10 +49,111 @@ void burst_free_all(burst_allocator* allocator) {
 		breport_free(entry->size, entry->tag);
 	}
 
+	platform_free(allocator->allocated_block, TRUE);
+
 	darray_destroy(allocator->entries);
 	allocator->entries = NULL;
 	allocator->total_size = 0;
+	allocator->max_alignment = 0;
 	allocator->allocated_block = NULL;
+}
+
+b8 frame_allocator_create(u64 capacity, memory_tag tag, frame_allocator* out_allocator) {
+	BX_ASSERT(capacity > 0 && tag < MEMORY_TAG_MAX_TAGS && out_allocator != NULL && "Invalid arguments passed to frame_allocator_create");
+	out_allocator->memory = ballocate(capacity, tag);
+	if (!out_allocator->memory) return FALSE;
+
+	out_allocator->capacity = capacity;
+	out_allocator->offset = 0;
+	out_allocator->tag = tag;
+	return TRUE;
+}
+
+void* frame_allocator_allocate(frame_allocator* allocator, u64 size) {
+	BX_ASSERT(allocator != NULL && allocator->memory != NULL && size > 0 && "Invalid arguments passed to frame_allocator_allocate");
+	u64 aligned_size = alignment(size, 8);
+
+	if (allocator->offset + aligned_size > allocator->capacity) {
+		BX_ERROR("Frame allocator exhausted (requested %llu bytes, %llu of %llu bytes used)", size, allocator->offset, allocator->capacity);
+		return NULL;
+	}
+
+	void* block = (u8*)allocator->memory + allocator->offset;
+	allocator->offset += aligned_size;
+	return bzero_memory(block, size);
+}
+
+void frame_allocator_reset(frame_allocator* allocator) {
+	BX_ASSERT(allocator != NULL && "Invalid arguments passed to frame_allocator_reset");
+	allocator->offset = 0;
+}
+
+void frame_allocator_destroy(frame_allocator* allocator) {
+	BX_ASSERT(allocator != NULL && "Invalid arguments passed to frame_allocator_destroy");
+	if (allocator->memory)
+		bfree(allocator->memory, allocator->capacity, allocator->tag);
+
+	bzero_memory(allocator, sizeof(frame_allocator));
+}
+
+
+void _pool_allocator_create(u64 block_size, u32 blocks_per_slab, memory_tag tag, pool_allocator* out_allocator) {
+	BX_ASSERT(block_size > 0 && blocks_per_slab > 0 && tag < MEMORY_TAG_MAX_TAGS && out_allocator != NULL && "Invalid arguments passed to pool_allocator_create");
+	bzero_memory(out_allocator, sizeof(pool_allocator));
 
-	platform_free(allocator->allocated_block, FALSE);
-}
\ No newline at end of file
+	out_allocator->block_size = alignment(BX_MAX(block_size, sizeof(void*)), 8ULL);
+	out_allocator->blocks_per_slab = blocks_per_slab;
+	out_allocator->tag = tag;
+}
+
+void* pool_allocator_allocate(pool_allocator* allocator) {
+	BX_ASSERT(allocator != NULL && allocator->block_size > 0 && "Invalid arguments passed to pool_allocator_allocate");
+
+	if (!allocator->free_list) {
+		if (!allocator->slabs)
+			allocator->slabs = darray_create(void*, MEMORY_TAG_CORE);
+
+		u8* slab = platform_allocate(allocator->block_size * allocator->blocks_per_slab, FALSE);
+		if (!slab) return NULL;
+
+		darray_push(allocator->slabs, (void*)slab);
+
+		// Thread every block of the new slab onto the free list, keeping address order.
+		for (u32 i = allocator->blocks_per_slab; i > 0; --i) {
+			void* block = slab + (u64)(i - 1) * allocator->block_size;
+			*(void**)block = allocator->free_list;
+			allocator->free_list = block;
+		}
+	}
+
+	void* block = allocator->free_list;
+	allocator->free_list = *(void**)block;
+	++allocator->allocated_count;
+
+	breport(allocator->block_size, allocator->tag);
+	return bzero_memory(block, allocator->block_size);
+}
+
+void pool_allocator_free(pool_allocator* allocator, void* block) {
+	BX_ASSERT(allocator != NULL && block != NULL && allocator->allocated_count > 0 && "Invalid arguments passed to pool_allocator_free");
+	*(void**)block = allocator->free_list;
+	allocator->free_list = block;
+	--allocator->allocated_count;
+
+	breport_free(allocator->block_size, allocator->tag);
+}
+
+void pool_allocator_destroy(pool_allocator* allocator) {
+	BX_ASSERT(allocator != NULL && "Invalid arguments passed to pool_allocator_destroy");
+	if (allocator->allocated_count > 0)
+		BX_WARN("Destroying pool allocator with %u blocks still in use", allocator->allocated_count);
+
+	if (allocator->slabs) {
+		for (u32 i = 0; i < darray_length(allocator->slabs); ++i)
+			platform_free(allocator->slabs[i], FALSE);
+
+		darray_destroy(allocator->slabs);
+	}
+
+	bzero_memory(allocator, sizeof(pool_allocator));
+}
@@ -10,6 +10,9 @@ typedef struct burst_allocator_entry {
 	// Size of the requested allocation in bytes.
 	u64 size;
 
+	// Required alignment of the allocation in bytes.
+	u64 alignment;
+
 	// Memory tag used for tracking/debugging allocator usage.
 	memory_tag tag;
 } burst_allocator_entry;
@@ -17,9 +20,12 @@ typedef struct burst_allocator_entry {
 // Custom allocator that collects multiple allocation requests and
 // fulfills them all at once using a single contiguous memory block.
 typedef struct burst_allocator {
-	// Total size in bytes required to satisfy all recorded allocation entries.
+	// Total size in bytes required to satisfy all recorded allocation entries, including alignment padding.
 	u64 total_size;
 
+	// Largest alignment requested by any allocation entry.
+	u64 max_alignment;
+
 	// Dynamic array of allocation entries describing individual requests.
 	burst_allocator_entry* entries;
 
@@ -30,8 +36,77 @@ typedef struct burst_allocator {
 // Adds a new allocation request to the burst allocator.
 void burst_add_block(burst_allocator* allocator, u64 size, memory_tag tag, void** out_pointer);
 
+// Adds a new allocation request to the burst allocator that starts on a boundary of 'alignment' bytes (must be a power of two).
+void burst_add_block_aligned(burst_allocator* allocator, u64 size, u64 alignment, memory_tag tag, void** out_pointer);
+
 // Performs a single allocation large enough to satisfy all recorded allocation requests.
 void* burst_allocate_all(burst_allocator* allocator);
 
 // Frees the single allocated memory block and clears all allocation entries, resetting the allocator to an empty state.
-void burst_free_all(burst_allocator* allocator);
\ No newline at end of file
+void burst_free_all(burst_allocator* allocator);
+
+// Linear (bump) allocator that hands out transient memory from a single pre-allocated block.
+// Individual allocations are never freed, instead the whole allocator is reset once its contents are no longer in use.
+typedef struct frame_allocator {
+	// Total size in bytes of the backing memory block.
+	u64 capacity;
+
+	// Offset in bytes of the next free byte within the backing memory block.
+	u64 offset;
+
+	// Memory tag used for tracking/debugging allocator usage.
+	memory_tag tag;
+
+	// Pointer to the single contiguous memory block backing all allocations.
+	void* memory;
+} frame_allocator;
+
+// Allocates the backing memory block of a frame allocator.
+b8 frame_allocator_create(u64 capacity, memory_tag tag, frame_allocator* out_allocator);
+
+// Returns a zeroed, 8-byte aligned block of memory from the frame allocator, or NULL if the allocator is exhausted.
+void* frame_allocator_allocate(frame_allocator* allocator, u64 size);
+
+// Invalidates every allocation made from the frame allocator, allowing its memory to be reused.
+void frame_allocator_reset(frame_allocator* allocator);
+
+// Frees the backing memory block of a frame allocator.
+void frame_allocator_destroy(frame_allocator* allocator);
+
+
+// Fixed-size object allocator that carves equally sized blocks out of larger slabs.
+// Freed blocks are kept in an intrusive free list so both allocation and free are O(1).
+typedef struct pool_allocator {
+	// Size in bytes of a single block, rounded up to hold at least a free list link.
+	u64 block_size;
+
+	// Number of blocks carved out of each slab.
+	u32 blocks_per_slab;
+
+	// Number of blocks currently handed out by the pool.
+	u32 allocated_count;
+
+	// Memory tag used for tracking/debugging allocator usage.
+	memory_tag tag;
+
+	// Dynamic array of slab pointers owned by the pool.
+	void** slabs;
+
+	// Head of the intrusive singly linked list of free blocks.
+	void* free_list;
+} pool_allocator;
+
+// Initializes a pool allocator handing out blocks of 'block_size' bytes. No memory is allocated until the first block is requested.
+void _pool_allocator_create(u64 block_size, u32 blocks_per_slab, memory_tag tag, pool_allocator* out_allocator);
+
+// Returns a zeroed block from the pool, allocating a new slab if every existing block is in use.
+void* pool_allocator_allocate(pool_allocator* allocator);
+
+// Returns a block to the pool so it can be reused by a later allocation.
+void pool_allocator_free(pool_allocator* allocator, void* block);
+
+// Frees every slab owned by the pool. Any blocks still in use become invalid.
+void pool_allocator_destroy(pool_allocator* allocator);
+
+#define pool_allocator_create(type, blocks_per_slab, tag, out_allocator) \
+	_pool_allocator_create(sizeof(type), blocks_per_slab, tag, out_allocator)
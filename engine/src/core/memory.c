@@ -2,13 +2,51 @@
 #include "memory.h"
 
 #include "platform/platform.h"
+#include "platform/threading.h"
+
+#include "tlsf.h"
+#include "thread_cache.h"
+#include "allocation_tracker.h"
+
+typedef struct memory_system_state {
+	memory_allocator_type allocator_type;
+	tlsf_allocator tlsf;
+	b8 thread_cache_enabled;
+	b8 call_sites_tracked;
+} memory_system_state;
+
+static b8 is_initialized = FALSE;
+static memory_system_state state = { 0 };
+
+static const char* tag_names[] = {
+	"UNKNOWN",
+	"ENGINE",
+	"PLATFORM",
+	"CORE",
+	"RESOURCES",
+	"RENDERER"};
 
 #if BOX_ENABLE_DIAGNOSTICS
 
-typedef struct memory_stats {
-	u64 total_allocated;
-	u64 tagged_allocations[MEMORY_TAG_MAX_TAGS];
-} memory_stats;
+// Live counters behind memory_tag_stats, updated atomically from any thread.
+typedef struct memory_counters {
+	volatile u64 current_bytes;
+	volatile u64 peak_bytes;
+	volatile u64 allocation_count;
+	volatile u64 free_count;
+
+	// Accumulated since the last memory_frame_mark.
+	volatile u64 frame_allocated_bytes;
+	volatile u64 frame_freed_bytes;
+	volatile u64 frame_allocation_count;
+	volatile u64 frame_free_count;
+
+	// Values of the frame closed by the last memory_frame_mark.
+	volatile u64 last_frame_allocated_bytes;
+	volatile u64 last_frame_freed_bytes;
+	volatile u64 last_frame_allocation_count;
+	volatile u64 last_frame_free_count;
+} memory_counters;
 
 static const char* tag_strings[] = {
     "UNKNOWN   ",
@@ -19,46 +57,258 @@ static const char* tag_strings[] = {
 	"RENDERER  ",
 	"TOTAL     "};
 
-static b8 is_initialized = FALSE;
-static memory_stats stats = { 0 };
+// One entry per tag, the last entry tracks every tag combined.
+static memory_counters counters[MEMORY_TAG_MAX_TAGS + 1] = { 0 };
+static volatile u64 frame_index = 0;
+static _Thread_local u64 thread_allocation_count = 0;
+
+static void counters_allocate(memory_counters* c, u64 size) {
+	u64 current = atomic_add_u64(&c->current_bytes, size);
+	u64 peak = atomic_load_u64(&c->peak_bytes);
+	while (current > peak && !atomic_compare_exchange_u64(&c->peak_bytes, &peak, current));
+
+	atomic_add_u64(&c->allocation_count, 1);
+	atomic_add_u64(&c->frame_allocated_bytes, size);
+	atomic_add_u64(&c->frame_allocation_count, 1);
+}
+
+static void counters_free(memory_counters* c, u64 size) {
+	atomic_sub_u64(&c->current_bytes, size);
+	atomic_add_u64(&c->free_count, 1);
+	atomic_add_u64(&c->frame_freed_bytes, size);
+	atomic_add_u64(&c->frame_free_count, 1);
+}
+
+static void counters_read(memory_counters* c, memory_tag_stats* out_stats) {
+	out_stats->current_bytes = atomic_load_u64(&c->current_bytes);
+	out_stats->peak_bytes = atomic_load_u64(&c->peak_bytes);
+	out_stats->allocation_count = atomic_load_u64(&c->allocation_count);
+	out_stats->free_count = atomic_load_u64(&c->free_count);
+	out_stats->frame_allocated_bytes = atomic_load_u64(&c->last_frame_allocated_bytes);
+	out_stats->frame_freed_bytes = atomic_load_u64(&c->last_frame_freed_bytes);
+	out_stats->frame_allocation_count = atomic_load_u64(&c->last_frame_allocation_count);
+	out_stats->frame_free_count = atomic_load_u64(&c->last_frame_free_count);
+}
+
+#endif
+
+// Backing allocator for thread cache spans, these are not reported as tagged allocations.
+static void* backing_allocate(u64 size, u64 align) {
+	return state.allocator_type == MEMORY_ALLOCATOR_TLSF ? 
+		tlsf_allocate(&state.tlsf, size, BX_MAX(align, (u64)TLSF_ALIGN_SIZE)) : 
+		platform_allocate_aligned(size, align);
+}
+
+static void backing_free(void* block) {
+	if (state.allocator_type == MEMORY_ALLOCATOR_TLSF)
+		tlsf_free(&state.tlsf, block);
+	else
+		platform_free(block, TRUE);
+}
+
+memory_config memory_default_config() {
+	memory_config config = {};
+	config.allocator_type = MEMORY_ALLOCATOR_PLATFORM;
+	config.tlsf_region_size = 64 * 1024 * 1024;
+	config.enable_thread_cache = TRUE;
+	config.track_call_sites = FALSE;
+	return config;
+}
+
+b8 memory_init(memory_config* config) {
+	BX_ASSERT(config != NULL && "Invalid arguments passed to memory_init");
+	BX_ASSERT(!is_initialized && "Memory system initialized twice");
+#if BOX_ENABLE_DIAGNOSTICS
+	BX_ASSERT(counters[MEMORY_TAG_MAX_TAGS].current_bytes == 0 && "memory_init must be called while no engine allocation is live");
+#endif
+
+	state.allocator_type = config->allocator_type;
+
+	if (state.allocator_type == MEMORY_ALLOCATOR_TLSF && !tlsf_create(config->tlsf_region_size, &state.tlsf)) {
+		BX_ERROR("Failed to reserve initial TLSF region of %llu bytes", config->tlsf_region_size);
+		state.allocator_type = MEMORY_ALLOCATOR_PLATFORM;
+		return FALSE;
+	}
+
+	if (config->enable_thread_cache) {
+		thread_cache_system_init(backing_allocate, backing_free);
+		state.thread_cache_enabled = TRUE;
+	}
 
+#if BOX_ENABLE_DIAGNOSTICS
+	if (config->track_call_sites) {
+		state.call_sites_tracked = allocation_tracker_init();
+		if (!state.call_sites_tracked) BX_WARN("Failed to start allocation call site tracking");
+	}
 #endif
 
+	is_initialized = TRUE;
+	return TRUE;
+}
+
 void memory_shutdown() {
 #if BOX_ENABLE_DIAGNOSTICS
-	if (stats.total_allocated == 0) return;
 	for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i) {
-		if (stats.tagged_allocations[i] == 0) continue;
-		BX_ERROR("Unfreed %llu bytes on MEMORY_TAG_%s", stats.tagged_allocations[i], tag_strings[i]);
+		u64 unfreed = atomic_load_u64(&counters[i].current_bytes);
+		if (unfreed == 0) continue;
+		BX_ERROR("Unfreed %llu bytes on MEMORY_TAG_%s", unfreed, tag_strings[i]);
+	}
+
+	if (state.call_sites_tracked) {
+		if (atomic_load_u64(&counters[MEMORY_TAG_MAX_TAGS].current_bytes) > 0)
+			allocation_tracker_dump(TRUE, NULL);
+
+		allocation_tracker_shutdown();
+		state.call_sites_tracked = FALSE;
 	}
 
 #endif
+	if (state.thread_cache_enabled)
+		thread_cache_system_shutdown();
+
+	if (state.allocator_type == MEMORY_ALLOCATOR_TLSF)
+		tlsf_destroy(&state.tlsf);
+
+	state.thread_cache_enabled = FALSE;
+	state.allocator_type = MEMORY_ALLOCATOR_PLATFORM;
+	is_initialized = FALSE;
+}
+
+void memory_thread_shutdown() {
+	if (state.thread_cache_enabled)
+		thread_cache_release_current();
 }
 
-void* ballocate(u64 size, memory_tag tag) {
+void* _ballocate(u64 size, memory_tag tag, const char* file, u32 line) {
 	BX_ASSERT(tag != MEMORY_TAG_UNKNOWN && "Memory allocated on unknown tag");
 
+	void* block = NULL;
+	if (state.thread_cache_enabled && size <= THREAD_CACHE_MAX_SIZE)
+		block = thread_cache_allocate(size);
+	else if (state.allocator_type == MEMORY_ALLOCATOR_TLSF)
+		block = tlsf_allocate(&state.tlsf, size, TLSF_ALIGN_SIZE);
+	else
+		block = platform_allocate(size, FALSE);
+	if (!block) return NULL;
+
+#if BOX_ENABLE_DIAGNOSTICS
+	if (state.call_sites_tracked) allocation_tracker_record(block, size, tag, file, line);
+#endif
+
 	breport(size, tag);
-	return bzero_memory(platform_allocate(size, FALSE), size);
+	return bzero_memory(block, size);
 }
 
 void bfree(const void* block, u64 size, memory_tag tag) {
 	breport_free(size, tag);
-	platform_free(block, FALSE);
+
+#if BOX_ENABLE_DIAGNOSTICS
+	if (state.call_sites_tracked) allocation_tracker_remove(block);
+#endif
+
+	if (state.thread_cache_enabled && size <= THREAD_CACHE_MAX_SIZE)
+		thread_cache_free((void*)block);
+	else if (state.allocator_type == MEMORY_ALLOCATOR_TLSF)
+		tlsf_free(&state.tlsf, (void*)block);
+	else
+		platform_free(block, FALSE);
+}
+
+void* _ballocate_aligned(u64 size, u64 alignment, memory_tag tag, const char* file, u32 line) {
+	BX_ASSERT(tag != MEMORY_TAG_UNKNOWN && "Memory allocated on unknown tag");
+	BX_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	void* block = state.allocator_type == MEMORY_ALLOCATOR_TLSF ? 
+		tlsf_allocate(&state.tlsf, size, alignment) : 
+		platform_allocate_aligned(size, alignment);
+	if (!block) return NULL;
+
+#if BOX_ENABLE_DIAGNOSTICS
+	if (state.call_sites_tracked) allocation_tracker_record(block, size, tag, file, line);
+#endif
+
+	breport(size, tag);
+	return bzero_memory(block, size);
+}
+
+void bfree_aligned(const void* block, u64 size, memory_tag tag) {
+	breport_free(size, tag);
+
+#if BOX_ENABLE_DIAGNOSTICS
+	if (state.call_sites_tracked) allocation_tracker_remove(block);
+#endif
+
+	if (state.allocator_type == MEMORY_ALLOCATOR_TLSF)
+		tlsf_free(&state.tlsf, (void*)block);
+	else
+		platform_free(block, TRUE);
 }
 
 void breport(u64 size, memory_tag tag) {
 #if BOX_ENABLE_DIAGNOSTICS
-	stats.total_allocated += size;
-	stats.tagged_allocations[tag] += size;
+	counters_allocate(&counters[tag], size);
+	counters_allocate(&counters[MEMORY_TAG_MAX_TAGS], size);
+	++thread_allocation_count;
 #endif
 }
 
 void breport_free(u64 size, memory_tag tag) {
 #if BOX_ENABLE_DIAGNOSTICS
-	stats.total_allocated -= size;
-	stats.tagged_allocations[tag] -= size;
+	counters_free(&counters[tag], size);
+	counters_free(&counters[MEMORY_TAG_MAX_TAGS], size);
+#endif
+}
+
+void memory_frame_mark() {
+#if BOX_ENABLE_DIAGNOSTICS
+	// Every allocation lands in exactly one frame, even if it races with the exchange.
+	for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS + 1; ++i) {
+		memory_counters* c = &counters[i];
+		atomic_store_u64(&c->last_frame_allocated_bytes, atomic_exchange_u64(&c->frame_allocated_bytes, 0));
+		atomic_store_u64(&c->last_frame_freed_bytes, atomic_exchange_u64(&c->frame_freed_bytes, 0));
+		atomic_store_u64(&c->last_frame_allocation_count, atomic_exchange_u64(&c->frame_allocation_count, 0));
+		atomic_store_u64(&c->last_frame_free_count, atomic_exchange_u64(&c->frame_free_count, 0));
+	}
+
+	atomic_add_u64(&frame_index, 1);
+#endif
+}
+
+void memory_get_stats(memory_stats* out_stats) {
+	BX_ASSERT(out_stats != NULL && "Invalid arguments passed to memory_get_stats");
+	bzero_memory(out_stats, sizeof(memory_stats));
+
+#if BOX_ENABLE_DIAGNOSTICS
+	for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
+		counters_read(&counters[i], &out_stats->tags[i]);
+
+	counters_read(&counters[MEMORY_TAG_MAX_TAGS], &out_stats->total);
+	out_stats->frame_index = atomic_load_u64(&frame_index);
+	out_stats->diagnostics_enabled = TRUE;
+#endif
+}
+
+u64 memory_get_thread_allocation_count() {
+#if BOX_ENABLE_DIAGNOSTICS
+	return thread_allocation_count;
+#else
+	return 0;
+#endif
+}
+
+u32 memory_dump_call_sites(b8 live_only, const char* path) {
+#if BOX_ENABLE_DIAGNOSTICS
+	if (state.call_sites_tracked) 
+		return allocation_tracker_dump(live_only, path);
+
+	BX_WARN("memory_dump_call_sites called without memory_config.track_call_sites set");
 #endif
+	return 0;
+}
+
+const char* memory_tag_name(memory_tag tag) {
+	BX_ASSERT(tag < MEMORY_TAG_MAX_TAGS && "Invalid arguments passed to memory_tag_name");
+	return tag_names[tag];
 }
 
 void* bzero_memory(void* block, u64 size) {
@@ -69,6 +319,10 @@ void* bcopy_memory(void* dest, const void* source, u64 size) {
 	return platform_copy_memory(dest, source, size);
 }
 
+void* bmove_memory(void* dest, const void* source, u64 size) {
+	return platform_move_memory(dest, source, size);
+}
+
 void* bset_memory(void* dest, i32 value, u64 size) {
 	return platform_set_memory(dest, value, size);
 }
@@ -77,36 +331,67 @@ b8 bcmp_memory(void* buf1, void* buf2, u64 size) {
 	return platform_compare_memory(buf1, buf2, size);
 }
 
-void show_memory_stats() {
 #if BOX_ENABLE_DIAGNOSTICS
-	u64 total = 0;
-
+// Picks the largest binary unit that keeps 'bytes' at or above 1.
+const char* get_memory_unit(u64 bytes, f64* out_amount) {
 	const u64 gib = 1024 * 1024 * 1024;
 	const u64 mib = 1024 * 1024;
 	const u64 kib = 1024;
 
+	if (bytes >= gib) {
+		*out_amount = bytes / (f64)gib;
+		return "GiB";
+	}
+	else if (bytes >= mib) {
+		*out_amount = bytes / (f64)mib;
+		return "MiB";
+	}
+	else if (bytes >= kib) {
+		*out_amount = bytes / (f64)kib;
+		return "KiB";
+	}
+
+	*out_amount = (f64)bytes;
+	return "B";
+}
+#endif
+
+void show_memory_stats() {
+#if BOX_ENABLE_DIAGNOSTICS
+	memory_stats stats = {};
+	memory_get_stats(&stats);
+
 	BX_TRACE("System memory use (tagged):");
 	for (u32 i = 0; i < MEMORY_TAG_MAX_TAGS + 1; ++i) {
-		u64 raw_amount = i < MEMORY_TAG_MAX_TAGS ? stats.tagged_allocations[i] : total;
-		total += raw_amount;
-
-		const char* unit = "B";
-		double amount = (double)raw_amount;
-
-		if (raw_amount >= gib) {
-			unit = "GiB";
-			amount = raw_amount / (double)gib;
-		}
-		else if (raw_amount >= mib) {
-			unit = "MiB";
-			amount = raw_amount / (double)mib;
-		}
-		else if (raw_amount >= kib) {
-			unit = "KiB";
-			amount = raw_amount / (double)kib;
-		}
-
-		BX_TRACE("  %s | %.2f%s", tag_strings[i], amount, unit);
+		memory_tag_stats* tag = i < MEMORY_TAG_MAX_TAGS ? &stats.tags[i] : &stats.total;
+
+		f64 amount = 0, peak = 0;
+		const char* unit = get_memory_unit(tag->current_bytes, &amount);
+		const char* peak_unit = get_memory_unit(tag->peak_bytes, &peak);
+
+		BX_TRACE("  %s | %.2f%s (peak %.2f%s, %llu allocs, %llu frees)", 
+			tag_strings[i], amount, unit, peak, peak_unit, tag->allocation_count, tag->free_count);
+	}
+
+	if (state.allocator_type == MEMORY_ALLOCATOR_TLSF) {
+		tlsf_stats tlsf = {};
+		tlsf_get_stats(&state.tlsf, &tlsf);
+
+		f64 reserved, used, free, largest;
+		const char* reserved_unit = get_memory_unit(tlsf.reserved_bytes, &reserved);
+		const char* used_unit = get_memory_unit(tlsf.used_bytes, &used);
+		const char* free_unit = get_memory_unit(tlsf.free_bytes, &free);
+		const char* largest_unit = get_memory_unit(tlsf.largest_free_block, &largest);
+
+		// Share of free memory that can not be handed out as a single block.
+		f64 fragmentation = tlsf.free_bytes > 0 ? 
+			100.0 * (1.0 - (f64)tlsf.largest_free_block / (f64)tlsf.free_bytes) : 0.0;
+
+		BX_TRACE("TLSF allocator:");
+		BX_TRACE("  REGIONS    | %u (%.2f%s reserved)", tlsf.region_count, reserved, reserved_unit);
+		BX_TRACE("  USED       | %.2f%s", used, used_unit);
+		BX_TRACE("  FREE       | %.2f%s in %llu blocks (largest %.2f%s)", free, free_unit, tlsf.free_block_count, largest, largest_unit);
+		BX_TRACE("  FRAGMENTED | %.2f%%", fragmentation);
 	}
 #endif
-}
\ No newline at end of file
+}
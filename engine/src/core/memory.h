@@ -12,12 +12,86 @@ typedef enum {
 	MEMORY_TAG_MAX_TAGS,
 } memory_tag;
 
+typedef enum {
+	// Every allocation goes straight to the platform allocator.
+	MEMORY_ALLOCATOR_PLATFORM,
+
+	// Allocations are served by a TLSF allocator managing large regions mapped directly from the OS.
+	MEMORY_ALLOCATOR_TLSF,
+} memory_allocator_type;
+
+typedef struct memory_config {
+	// General purpose allocator backing ballocate / bfree.
+	memory_allocator_type allocator_type;
+
+	// Minimum size in bytes of each region reserved by the TLSF allocator.
+	u64 tlsf_region_size;
+
+	// Serves requests up to THREAD_CACHE_MAX_SIZE bytes from per-thread caches in front of the allocator above.
+	// Threads other than the main thread should call memory_thread_shutdown before they exit.
+	b8 enable_thread_cache;
+
+	// Records the file and line of every ballocate call so leaks and hot sites can be dumped.
+	// Only available when BOX_ENABLE_DIAGNOSTICS is set, adds a locked table lookup to every allocation.
+	b8 track_call_sites;
+} memory_config;
+
+// Counters for a single memory tag, or for every tag combined.
+typedef struct memory_tag_stats {
+	// Bytes currently allocated and the highest value this has reached.
+	u64 current_bytes;
+	u64 peak_bytes;
+
+	// Number of allocations and frees made since startup.
+	u64 allocation_count;
+	u64 free_count;
+
+	// Activity during the last frame closed by memory_frame_mark.
+	u64 frame_allocated_bytes;
+	u64 frame_freed_bytes;
+	u64 frame_allocation_count;
+	u64 frame_free_count;
+} memory_tag_stats;
+
+// Point in time copy of the memory counters, all zero when diagnostics are disabled.
+typedef struct memory_stats {
+	memory_tag_stats tags[MEMORY_TAG_MAX_TAGS];
+	memory_tag_stats total;
+
+	// Number of frames closed by memory_frame_mark.
+	u64 frame_index;
+
+	// True when the engine was built with BOX_ENABLE_DIAGNOSTICS, so the counters above are kept.
+	b8 diagnostics_enabled;
+} memory_stats;
+
+memory_config memory_default_config();
+
+// Selects the allocator backing ballocate, must be called while no engine allocation is live.
+// May be called again after memory_shutdown once every other thread has called memory_thread_shutdown.
+b8 memory_init(memory_config* config);
+
 void memory_shutdown();
 
-void* ballocate(u64 size, memory_tag tag);
+// Hands the calling thread's allocation cache over to the next thread that starts allocating.
+void memory_thread_shutdown();
+
+#if BOX_ENABLE_DIAGNOSTICS
+#define ballocate(size, tag) _ballocate(size, tag, __FILE__, __LINE__)
+#define ballocate_aligned(size, align, tag) _ballocate_aligned(size, align, tag, __FILE__, __LINE__)
+#else
+#define ballocate(size, tag) _ballocate(size, tag, NULL, 0)
+#define ballocate_aligned(size, align, tag) _ballocate_aligned(size, align, tag, NULL, 0)
+#endif
+
+void* _ballocate(u64 size, memory_tag tag, const char* file, u32 line);
 
 void bfree(const void* block, u64 size, memory_tag tag);
 
+void* _ballocate_aligned(u64 size, u64 alignment, memory_tag tag, const char* file, u32 line);
+
+void bfree_aligned(const void* block, u64 size, memory_tag tag);
+
 void breport(u64 size, memory_tag tag);
 
 void breport_free(u64 size, memory_tag tag);
@@ -26,8 +100,26 @@ void* bzero_memory(void* block, u64 size);
 
 void* bcopy_memory(void* dest, const void* source, u64 size);
 
+void* bmove_memory(void* dest, const void* source, u64 size);
+
 void* bset_memory(void* dest, i32 value, u64 size);
 
 b8 bcmp_memory(void* buf1, void* buf2, u64 size);
 
+// Closes the current frame, the per-frame counters of the next snapshot cover the frame just closed.
+void memory_frame_mark();
+
+// Copies the current counters into 'out_stats'. Safe to call while other threads allocate.
+void memory_get_stats(memory_stats* out_stats);
+
+// Number of allocations made by the calling thread since it started, 0 when diagnostics are disabled.
+// The difference of two calls attributes allocations to the code in between, unaffected by other threads.
+u64 memory_get_thread_allocation_count();
+
+// Logs allocation call sites sorted by volume and optionally writes them to 'path' as folded stacks.
+// Requires memory_config.track_call_sites, returns the number of sites reported.
+u32 memory_dump_call_sites(b8 live_only, const char* path);
+
+const char* memory_tag_name(memory_tag tag);
+
 void show_memory_stats();
\ No newline at end of file
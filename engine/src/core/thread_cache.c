@@ -0,0 +1,173 @@
+#include "defines.h"
+#include "thread_cache.h"
+
+#include "memory.h"
+
+#include "platform/threading.h"
+
+// Header at the start of every span, padded to a cache line so the blocks behind it stay 16 byte aligned.
+typedef struct thread_cache_span {
+	thread_cache* owner;
+	struct thread_cache_span* next;
+	u32 size_class;
+} thread_cache_span;
+
+#define THREAD_CACHE_SPAN_HEADER_SIZE BX_CACHE_LINE_SIZE
+
+static const u32 size_class_sizes[THREAD_CACHE_SIZE_CLASS_COUNT] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512,
+};
+
+static PFN_thread_cache_allocate backing_allocate = NULL;
+static PFN_thread_cache_free backing_free = NULL;
+
+// Every cache ever created, caches are only ever pushed so the list can be walked without a lock.
+static thread_cache* volatile caches = NULL;
+
+static _Thread_local thread_cache* local_cache = NULL;
+
+static inline u32 size_class_index(u64 size) {
+	if (size <= 16) return 0;
+	if (size <= 128) return (u32)((size + 15) / 16) - 1;
+	if (size <= 256) return 8 + (u32)((size - 129) / 32);
+	return 12 + (u32)((size - 257) / 64);
+}
+
+static inline thread_cache_span* span_of(void* block) {
+	return (thread_cache_span*)((u64)block & ~((u64)THREAD_CACHE_SPAN_SIZE - 1));
+}
+
+static thread_cache* thread_cache_acquire() {
+	// Adopt a cache released by a thread that exited before creating a new one.
+	for (thread_cache* cache = atomic_load_ptr((void* volatile*)&caches); cache; cache = cache->next) {
+		u64 expected = 0;
+		if (atomic_compare_exchange_u64(&cache->owned, &expected, 1)) 
+			return cache;
+	}
+
+	thread_cache* cache = backing_allocate(sizeof(thread_cache), BX_CACHE_LINE_SIZE);
+	if (!cache) return NULL;
+
+	bzero_memory(cache, sizeof(thread_cache));
+	cache->owned = 1;
+
+	void* head = atomic_load_ptr((void* volatile*)&caches);
+	do {
+		cache->next = head;
+	} while (!atomic_compare_exchange_ptr((void* volatile*)&caches, &head, cache));
+	return cache;
+}
+
+// Moves every block freed by other threads onto the local free lists.
+static void thread_cache_drain_remote(thread_cache* cache) {
+	void* block = atomic_exchange_ptr(&cache->remote_frees, NULL);
+	while (block) {
+		void* next = *(void**)block;
+		u32 index = span_of(block)->size_class;
+		*(void**)block = cache->free_lists[index];
+		cache->free_lists[index] = block;
+		block = next;
+	}
+}
+
+static b8 thread_cache_add_span(thread_cache* cache, u32 index) {
+	thread_cache_span* span = backing_allocate(THREAD_CACHE_SPAN_SIZE, THREAD_CACHE_SPAN_SIZE);
+	if (!span) return FALSE;
+
+	span->owner = cache;
+	span->size_class = index;
+	span->next = cache->spans;
+	cache->spans = span;
+
+	u32 block_size = size_class_sizes[index];
+	u64 block_count = (THREAD_CACHE_SPAN_SIZE - THREAD_CACHE_SPAN_HEADER_SIZE) / block_size;
+	cache->bump[index] = (u8*)span + THREAD_CACHE_SPAN_HEADER_SIZE;
+	cache->bump_end[index] = cache->bump[index] + block_count * block_size;
+	return TRUE;
+}
+
+void thread_cache_system_init(PFN_thread_cache_allocate allocate, PFN_thread_cache_free free) {
+	BX_ASSERT(allocate != NULL && free != NULL && "Invalid arguments passed to thread_cache_system_init");
+	backing_allocate = allocate;
+	backing_free = free;
+}
+
+void thread_cache_system_shutdown() {
+	thread_cache* cache = atomic_exchange_ptr((void* volatile*)&caches, NULL);
+	while (cache) {
+		thread_cache* next = cache->next;
+
+		thread_cache_span* span = cache->spans;
+		while (span) {
+			thread_cache_span* next_span = span->next;
+			backing_free(span);
+			span = next_span;
+		}
+
+		backing_free(cache);
+		cache = next;
+	}
+
+	local_cache = NULL;
+	backing_allocate = NULL;
+	backing_free = NULL;
+}
+
+void* thread_cache_allocate(u64 size) {
+	BX_ASSERT(size <= THREAD_CACHE_MAX_SIZE && backing_allocate != NULL && "Invalid arguments passed to thread_cache_allocate");
+
+	thread_cache* cache = local_cache;
+	if (!cache) {
+		cache = local_cache = thread_cache_acquire();
+		if (!cache) return NULL;
+	}
+
+	u32 index = size_class_index(size);
+	void* block = cache->free_lists[index];
+	if (!block && atomic_load_ptr(&cache->remote_frees) != NULL) {
+		thread_cache_drain_remote(cache);
+		block = cache->free_lists[index];
+	}
+
+	if (block) {
+		cache->free_lists[index] = *(void**)block;
+		return block;
+	}
+
+	if (cache->bump[index] == cache->bump_end[index] && !thread_cache_add_span(cache, index))
+		return NULL;
+
+	block = cache->bump[index];
+	cache->bump[index] += size_class_sizes[index];
+	return block;
+}
+
+void thread_cache_free(void* block) {
+	BX_ASSERT(block != NULL && "Invalid arguments passed to thread_cache_free");
+
+	thread_cache_span* span = span_of(block);
+	thread_cache* owner = span->owner;
+
+	if (owner == local_cache) {
+		*(void**)block = owner->free_lists[span->size_class];
+		owner->free_lists[span->size_class] = block;
+		return;
+	}
+
+	// Only the owner ever pops, and it takes the whole list at once, so a plain CAS push is ABA safe.
+	void* head = atomic_load_ptr(&owner->remote_frees);
+	do {
+		*(void**)block = head;
+	} while (!atomic_compare_exchange_ptr(&owner->remote_frees, &head, block));
+}
+
+void thread_cache_release_current() {
+	if (!local_cache) return;
+
+	// Full barrier so the adopting thread sees the free lists as this thread left them.
+	u64 expected = 1;
+	atomic_compare_exchange_u64(&local_cache->owned, &expected, 0);
+	local_cache = NULL;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+
+// Largest request in bytes served by the per-thread caches, bigger requests go to the backing allocator.
+#define THREAD_CACHE_MAX_SIZE 512
+
+// Number of size classes between 16 and THREAD_CACHE_MAX_SIZE bytes.
+#define THREAD_CACHE_SIZE_CLASS_COUNT 16
+
+// Size of the spans each thread carves its blocks from. Spans are aligned to their size,
+// so the owning span (and thread) of any block can be found by masking its address.
+#define THREAD_CACHE_SPAN_SIZE (64 * 1024)
+
+// Reserves 'size' bytes aligned to 'alignment' for a span or cache, and releases it again.
+typedef void* (*PFN_thread_cache_allocate)(u64 size, u64 alignment);
+typedef void (*PFN_thread_cache_free)(void* block);
+
+struct thread_cache_span;
+
+// Per-thread size-class magazines. Only the owning thread touches the free lists,
+// other threads hand blocks back through the lock-free 'remote_frees' list.
+typedef struct thread_cache {
+	// Blocks freed by the owning thread, one intrusive list per size class.
+	void* free_lists[THREAD_CACHE_SIZE_CLASS_COUNT];
+
+	// Untouched tail of the newest span of each size class.
+	u8* bump[THREAD_CACHE_SIZE_CLASS_COUNT];
+	u8* bump_end[THREAD_CACHE_SIZE_CLASS_COUNT];
+
+	// Every span owned by this cache, released on shutdown.
+	struct thread_cache_span* spans;
+
+	// Blocks freed by other threads, pushed with a CAS and drained all at once by the owner.
+	void* volatile remote_frees;
+
+	// Non-zero while a thread owns the cache, released caches are adopted by the next new thread.
+	volatile u64 owned;
+
+	// Next cache in the global registry.
+	struct thread_cache* next;
+} thread_cache;
+
+// Sets the allocator spans are reserved from. Must be called before any thread uses its cache.
+void thread_cache_system_init(PFN_thread_cache_allocate allocate, PFN_thread_cache_free free);
+
+// Releases every span of every cache. No thread may use its cache afterwards.
+void thread_cache_system_shutdown();
+
+// Returns a block of at least 'size' bytes (up to THREAD_CACHE_MAX_SIZE) from the calling thread's cache.
+void* thread_cache_allocate(u64 size);
+
+// Returns a block to the cache of the thread that allocated it, from any thread.
+void thread_cache_free(void* block);
+
+// Detaches the calling thread from its cache so another thread can adopt it, call before a thread exits.
+void thread_cache_release_current();
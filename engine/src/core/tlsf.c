@@ -0,0 +1,444 @@
+#include "defines.h"
+#include "tlsf.h"
+
+#include "platform/platform.h"
+
+// Block layout follows the classic TLSF design:
+// - 'prev_physical' is only valid while the previous block is free, it overlaps the tail of that block's payload.
+// - 'size' holds the payload size, its two lowest bits store the free state of this and the previous block.
+//   Payload sizes are kept at 8 bytes past a multiple of TLSF_ALIGN_SIZE, so with the size field in between
+//   every payload starts on a TLSF_ALIGN_SIZE boundary once the first one of a region does.
+// - 'next_free' / 'prev_free' are only valid while the block is free, they overlap the start of the payload.
+typedef struct tlsf_block {
+	struct tlsf_block* prev_physical;
+	u64 size;
+	struct tlsf_block* next_free;
+	struct tlsf_block* prev_free;
+} tlsf_block;
+
+// Header placed at the start of every region reserved from the platform.
+typedef struct tlsf_region {
+	struct tlsf_region* next;
+	u64 size;
+} tlsf_region;
+
+#define TLSF_BLOCK_FREE_BIT (1ULL << 0)
+#define TLSF_BLOCK_PREV_FREE_BIT (1ULL << 1)
+#define TLSF_BLOCK_SIZE_MASK (~(TLSF_BLOCK_FREE_BIT | TLSF_BLOCK_PREV_FREE_BIT))
+
+// Only the size field is overhead for a used block, 'prev_physical' lives in the previous block.
+#define TLSF_BLOCK_OVERHEAD sizeof(u64)
+#define TLSF_BLOCK_START_OFFSET (sizeof(tlsf_block*) + sizeof(u64))
+#define TLSF_BLOCK_SIZE_MIN (sizeof(tlsf_block) - sizeof(tlsf_block*))
+#define TLSF_BLOCK_SIZE_MAX (1ULL << TLSF_FL_INDEX_MAX)
+
+// A region needs room for its header, the first block's size field, the zero sized sentinel block
+// and the padding that puts the first payload and the block size on their boundaries.
+#define TLSF_REGION_OVERHEAD (sizeof(tlsf_region) + 2 * TLSF_BLOCK_OVERHEAD + 2 * TLSF_ALIGN_SIZE)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+
+static inline i32 tlsf_ffs(u64 word) {
+	unsigned long index;
+	return _BitScanForward64(&index, word) ? (i32)index : -1;
+}
+
+static inline i32 tlsf_fls(u64 word) {
+	unsigned long index;
+	return _BitScanReverse64(&index, word) ? (i32)index : -1;
+}
+#else
+static inline i32 tlsf_ffs(u64 word) {
+	return word ? __builtin_ctzll(word) : -1;
+}
+
+static inline i32 tlsf_fls(u64 word) {
+	return word ? 63 - __builtin_clzll(word) : -1;
+}
+#endif
+
+static inline u64 tlsf_block_size(const tlsf_block* block) {
+	return block->size & TLSF_BLOCK_SIZE_MASK;
+}
+
+static inline void tlsf_block_set_size(tlsf_block* block, u64 size) {
+	block->size = size | (block->size & ~TLSF_BLOCK_SIZE_MASK);
+}
+
+static inline b8 tlsf_block_is_last(const tlsf_block* block) {
+	return tlsf_block_size(block) == 0;
+}
+
+static inline b8 tlsf_block_is_free(const tlsf_block* block) {
+	return (block->size & TLSF_BLOCK_FREE_BIT) != 0;
+}
+
+static inline b8 tlsf_block_is_prev_free(const tlsf_block* block) {
+	return (block->size & TLSF_BLOCK_PREV_FREE_BIT) != 0;
+}
+
+static inline void tlsf_block_set_free(tlsf_block* block, b8 free) {
+	block->size = free ? (block->size | TLSF_BLOCK_FREE_BIT) : (block->size & ~TLSF_BLOCK_FREE_BIT);
+}
+
+static inline void tlsf_block_set_prev_free(tlsf_block* block, b8 free) {
+	block->size = free ? (block->size | TLSF_BLOCK_PREV_FREE_BIT) : (block->size & ~TLSF_BLOCK_PREV_FREE_BIT);
+}
+
+static inline void* tlsf_block_to_ptr(const tlsf_block* block) {
+	return (u8*)block + TLSF_BLOCK_START_OFFSET;
+}
+
+static inline tlsf_block* tlsf_block_from_ptr(const void* ptr) {
+	return (tlsf_block*)((u8*)ptr - TLSF_BLOCK_START_OFFSET);
+}
+
+static inline tlsf_block* tlsf_block_next(const tlsf_block* block) {
+	BX_ASSERT(!tlsf_block_is_last(block) && "TLSF: Walked past the last block of a region");
+	return (tlsf_block*)((u8*)tlsf_block_to_ptr(block) + tlsf_block_size(block) - TLSF_BLOCK_OVERHEAD);
+}
+
+static inline tlsf_block* tlsf_block_link_next(tlsf_block* block) {
+	tlsf_block* next = tlsf_block_next(block);
+	next->prev_physical = block;
+	return next;
+}
+
+static inline void tlsf_block_mark_as_free(tlsf_block* block) {
+	tlsf_block* next = tlsf_block_link_next(block);
+	tlsf_block_set_prev_free(next, TRUE);
+	tlsf_block_set_free(block, TRUE);
+}
+
+static inline void tlsf_block_mark_as_used(tlsf_block* block) {
+	tlsf_block* next = tlsf_block_next(block);
+	tlsf_block_set_prev_free(next, FALSE);
+	tlsf_block_set_free(block, FALSE);
+}
+
+// Maps a block size to the free list it is stored in.
+static void tlsf_mapping_insert(u64 size, i32* fl, i32* sl) {
+	if (size < TLSF_SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = (i32)(size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT));
+		return;
+	}
+
+	i32 first = tlsf_fls(size);
+	*sl = (i32)(size >> (first - TLSF_SL_INDEX_COUNT_LOG2)) ^ (1 << TLSF_SL_INDEX_COUNT_LOG2);
+	*fl = first - (TLSF_FL_INDEX_SHIFT - 1);
+}
+
+// Maps a requested size to the first free list whose blocks are all guaranteed to be large enough.
+static void tlsf_mapping_search(u64 size, i32* fl, i32* sl) {
+	if (size >= TLSF_SMALL_BLOCK_SIZE)
+		size += (1ULL << (tlsf_fls(size) - TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+
+	tlsf_mapping_insert(size, fl, sl);
+}
+
+static tlsf_block* tlsf_search_suitable_block(tlsf_allocator* allocator, i32* fl, i32* sl) {
+	u32 sl_map = allocator->sl_bitmap[*fl] & (~0U << *sl);
+
+	if (!sl_map) {
+		// No block in this first-level class, look in the next non-empty larger one.
+		u64 fl_map = allocator->fl_bitmap & (~0ULL << (*fl + 1));
+		if (!fl_map) return NULL;
+
+		*fl = tlsf_ffs(fl_map);
+		sl_map = allocator->sl_bitmap[*fl];
+	}
+
+	*sl = tlsf_ffs(sl_map);
+	return allocator->blocks[*fl][*sl];
+}
+
+static void tlsf_remove_free_block(tlsf_allocator* allocator, tlsf_block* block, i32 fl, i32 sl) {
+	tlsf_block* prev = block->prev_free;
+	tlsf_block* next = block->next_free;
+	if (next) next->prev_free = prev;
+	if (prev) prev->next_free = next;
+
+	if (allocator->blocks[fl][sl] == block) {
+		allocator->blocks[fl][sl] = next;
+
+		if (!next) {
+			allocator->sl_bitmap[fl] &= ~(1U << sl);
+			if (!allocator->sl_bitmap[fl])
+				allocator->fl_bitmap &= ~(1ULL << fl);
+		}
+	}
+}
+
+static void tlsf_insert_free_block(tlsf_allocator* allocator, tlsf_block* block, i32 fl, i32 sl) {
+	tlsf_block* current = allocator->blocks[fl][sl];
+	block->next_free = current;
+	block->prev_free = NULL;
+	if (current) current->prev_free = block;
+
+	allocator->blocks[fl][sl] = block;
+	allocator->fl_bitmap |= (1ULL << fl);
+	allocator->sl_bitmap[fl] |= (1U << sl);
+}
+
+static void tlsf_block_remove(tlsf_allocator* allocator, tlsf_block* block) {
+	i32 fl, sl;
+	tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+	tlsf_remove_free_block(allocator, block, fl, sl);
+}
+
+static void tlsf_block_insert(tlsf_allocator* allocator, tlsf_block* block) {
+	i32 fl, sl;
+	tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+	tlsf_insert_free_block(allocator, block, fl, sl);
+}
+
+static b8 tlsf_block_can_split(tlsf_block* block, u64 size) {
+	return tlsf_block_size(block) >= sizeof(tlsf_block) + size;
+}
+
+// Splits 'size' bytes off the front of a block and returns the free remainder.
+static tlsf_block* tlsf_block_split(tlsf_block* block, u64 size) {
+	tlsf_block* remaining = (tlsf_block*)((u8*)tlsf_block_to_ptr(block) + size - TLSF_BLOCK_OVERHEAD);
+	u64 remain_size = tlsf_block_size(block) - (size + TLSF_BLOCK_OVERHEAD);
+
+	remaining->size = remain_size;
+	tlsf_block_set_size(block, size);
+	tlsf_block_mark_as_free(remaining);
+	return remaining;
+}
+
+// Merges a block into its free physical predecessor.
+static tlsf_block* tlsf_block_absorb(tlsf_block* prev, tlsf_block* block) {
+	prev->size += tlsf_block_size(block) + TLSF_BLOCK_OVERHEAD;
+	tlsf_block_link_next(prev);
+	return prev;
+}
+
+static tlsf_block* tlsf_block_merge_prev(tlsf_allocator* allocator, tlsf_block* block) {
+	if (tlsf_block_is_prev_free(block)) {
+		tlsf_block* prev = block->prev_physical;
+		tlsf_block_remove(allocator, prev);
+		block = tlsf_block_absorb(prev, block);
+	}
+
+	return block;
+}
+
+static tlsf_block* tlsf_block_merge_next(tlsf_allocator* allocator, tlsf_block* block) {
+	tlsf_block* next = tlsf_block_next(block);
+	if (tlsf_block_is_free(next)) {
+		tlsf_block_remove(allocator, next);
+		block = tlsf_block_absorb(block, next);
+	}
+
+	return block;
+}
+
+// Returns the unused tail of a free block back to the free lists.
+static void tlsf_block_trim_free(tlsf_allocator* allocator, tlsf_block* block, u64 size) {
+	if (tlsf_block_can_split(block, size)) {
+		tlsf_block* remaining = tlsf_block_split(block, size);
+		tlsf_block_link_next(block);
+		tlsf_block_set_prev_free(remaining, TRUE);
+		tlsf_block_insert(allocator, remaining);
+	}
+}
+
+// Returns the unused head of a free block back to the free lists, used to satisfy alignment.
+static tlsf_block* tlsf_block_trim_free_leading(tlsf_allocator* allocator, tlsf_block* block, u64 size) {
+	tlsf_block* remaining = block;
+	if (tlsf_block_can_split(block, size)) {
+		remaining = tlsf_block_split(block, size - TLSF_BLOCK_OVERHEAD);
+		tlsf_block_set_prev_free(remaining, TRUE);
+		tlsf_block_link_next(block);
+		tlsf_block_insert(allocator, block);
+	}
+
+	return remaining;
+}
+
+static tlsf_block* tlsf_block_locate_free(tlsf_allocator* allocator, u64 size) {
+	i32 fl = 0, sl = 0;
+	tlsf_mapping_search(size, &fl, &sl);
+	if (fl >= TLSF_FL_INDEX_COUNT) return NULL;
+
+	tlsf_block* block = tlsf_search_suitable_block(allocator, &fl, &sl);
+	if (block) {
+		BX_ASSERT(tlsf_block_size(block) >= size && "TLSF: Free list returned a block that is too small");
+		tlsf_remove_free_block(allocator, block, fl, sl);
+	}
+
+	return block;
+}
+
+// Rounds a request up so the size field and payload together span a multiple of 'align' bytes.
+static u64 tlsf_adjust_request_size(u64 size, u64 align) {
+	u64 aligned = alignment(size + TLSF_BLOCK_OVERHEAD, align) - TLSF_BLOCK_OVERHEAD;
+	if (aligned >= TLSF_BLOCK_SIZE_MAX) return 0;
+	return BX_MAX(aligned, TLSF_BLOCK_SIZE_MIN);
+}
+
+// Gets the first block of a region, its payload is the first TLSF_ALIGN_SIZE boundary after the region header and size field.
+static tlsf_block* tlsf_region_first_block(tlsf_region* region) {
+	u64 payload = alignment((u64)(region + 1) + TLSF_BLOCK_OVERHEAD, TLSF_ALIGN_SIZE);
+	return tlsf_block_from_ptr((void*)payload);
+}
+
+// Maps a new region straight from the OS, bypassing the C runtime heap, large enough for a search of 'min_block_size' bytes to succeed.
+static b8 tlsf_add_region(tlsf_allocator* allocator, u64 min_block_size) {
+	u64 search_size = min_block_size;
+	if (search_size >= TLSF_SMALL_BLOCK_SIZE)
+		search_size += (1ULL << (tlsf_fls(search_size) - TLSF_SL_INDEX_COUNT_LOG2));
+
+	u64 region_size = alignment(BX_MAX(allocator->region_size, search_size + TLSF_REGION_OVERHEAD), platform_get_page_size());
+	tlsf_region* region = platform_reserve_memory(region_size);
+	if (!region) return FALSE;
+
+	if (!platform_commit_memory(region, region_size)) {
+		platform_release_memory(region, region_size);
+		return FALSE;
+	}
+
+	region->size = region_size;
+	region->next = allocator->regions;
+	allocator->regions = region;
+
+	// The first block's 'prev_physical' field overlaps the region header,
+	// it is never accessed since there is no previous block.
+	tlsf_block* block = tlsf_region_first_block(region);
+
+	// Everything up to the sentinel's size field at the end of the region, rounded down to a valid block size.
+	u64 available = (u64)region + region_size - (u64)tlsf_block_to_ptr(block) - TLSF_BLOCK_OVERHEAD;
+	u64 block_bytes = ((available - TLSF_BLOCK_OVERHEAD) & ~(u64)(TLSF_ALIGN_SIZE - 1)) + TLSF_BLOCK_OVERHEAD;
+
+	block->size = block_bytes;
+	tlsf_block_set_free(block, TRUE);
+	tlsf_block_set_prev_free(block, FALSE);
+	tlsf_block_insert(allocator, block);
+
+	// Zero sized, used sentinel block terminating the region.
+	tlsf_block* sentinel = tlsf_block_link_next(block);
+	sentinel->size = 0;
+	tlsf_block_set_free(sentinel, FALSE);
+	tlsf_block_set_prev_free(sentinel, TRUE);
+	return TRUE;
+}
+
+b8 tlsf_create(u64 region_size, tlsf_allocator* out_allocator) {
+	BX_ASSERT(region_size > TLSF_REGION_OVERHEAD + TLSF_BLOCK_SIZE_MIN && out_allocator != NULL && "Invalid arguments passed to tlsf_create");
+	platform_set_memory(out_allocator, 0, sizeof(tlsf_allocator));
+	out_allocator->region_size = region_size;
+
+	if (!mutex_init(&out_allocator->lock, BOX_MUTEX_TYPE_PLAIN))
+		return FALSE;
+
+	return tlsf_add_region(out_allocator, TLSF_BLOCK_SIZE_MIN);
+}
+
+void tlsf_destroy(tlsf_allocator* allocator) {
+	BX_ASSERT(allocator != NULL && "Invalid arguments passed to tlsf_destroy");
+
+	tlsf_region* region = allocator->regions;
+	while (region) {
+		tlsf_region* next = region->next;
+		platform_release_memory(region, region->size);
+		region = next;
+	}
+
+	mutex_destroy(&allocator->lock);
+	platform_set_memory(allocator, 0, sizeof(tlsf_allocator));
+}
+
+void* tlsf_allocate(tlsf_allocator* allocator, u64 size, u64 align) {
+	BX_ASSERT(allocator != NULL && align > 0 && (align & (align - 1)) == 0 && "Invalid arguments passed to tlsf_allocate");
+
+	u64 adjust = tlsf_adjust_request_size(size, TLSF_ALIGN_SIZE);
+	if (!adjust) return NULL;
+
+	// Larger alignments over-allocate so that a leading gap large enough to be a free block can be split off.
+	u64 gap_minimum = sizeof(tlsf_block);
+	u64 aligned_size = align > TLSF_ALIGN_SIZE ? tlsf_adjust_request_size(adjust + align + gap_minimum, align) : adjust;
+	if (!aligned_size) return NULL;
+
+	mutex_lock(&allocator->lock);
+
+	tlsf_block* block = tlsf_block_locate_free(allocator, aligned_size);
+	if (!block && tlsf_add_region(allocator, aligned_size))
+		block = tlsf_block_locate_free(allocator, aligned_size);
+
+	if (!block) {
+		mutex_unlock(&allocator->lock);
+		return NULL;
+	}
+
+	if (align > TLSF_ALIGN_SIZE) {
+		u8* ptr = tlsf_block_to_ptr(block);
+		u8* aligned = (u8*)alignment((u64)ptr, align);
+		u64 gap = (u64)(aligned - ptr);
+
+		// The gap must be able to hold a free block header, otherwise skip to the next aligned address.
+		if (gap && gap < gap_minimum) {
+			u64 offset = BX_MAX(gap_minimum - gap, align);
+			aligned = (u8*)alignment((u64)(aligned + offset), align);
+			gap = (u64)(aligned - ptr);
+		}
+
+		if (gap)
+			block = tlsf_block_trim_free_leading(allocator, block, gap);
+	}
+
+	tlsf_block_trim_free(allocator, block, adjust);
+	tlsf_block_mark_as_used(block);
+
+	mutex_unlock(&allocator->lock);
+	return tlsf_block_to_ptr(block);
+}
+
+void tlsf_free(tlsf_allocator* allocator, void* ptr) {
+	BX_ASSERT(allocator != NULL && "Invalid arguments passed to tlsf_free");
+	if (!ptr) return;
+
+	mutex_lock(&allocator->lock);
+
+	tlsf_block* block = tlsf_block_from_ptr(ptr);
+	BX_ASSERT(!tlsf_block_is_free(block) && "TLSF: Block freed twice");
+
+	tlsf_block_mark_as_free(block);
+	block = tlsf_block_merge_prev(allocator, block);
+	block = tlsf_block_merge_next(allocator, block);
+	tlsf_block_insert(allocator, block);
+
+	mutex_unlock(&allocator->lock);
+}
+
+void tlsf_get_stats(tlsf_allocator* allocator, tlsf_stats* out_stats) {
+	BX_ASSERT(allocator != NULL && out_stats != NULL && "Invalid arguments passed to tlsf_get_stats");
+	platform_set_memory(out_stats, 0, sizeof(tlsf_stats));
+
+	mutex_lock(&allocator->lock);
+
+	for (tlsf_region* region = allocator->regions; region; region = region->next) {
+		++out_stats->region_count;
+		out_stats->reserved_bytes += region->size;
+
+		tlsf_block* block = tlsf_region_first_block(region);
+		while (!tlsf_block_is_last(block)) {
+			u64 size = tlsf_block_size(block);
+
+			if (tlsf_block_is_free(block)) {
+				++out_stats->free_block_count;
+				out_stats->free_bytes += size;
+				out_stats->largest_free_block = BX_MAX(out_stats->largest_free_block, size);
+			}
+			else {
+				out_stats->used_bytes += size;
+			}
+
+			block = tlsf_block_next(block);
+		}
+	}
+
+	mutex_unlock(&allocator->lock);
+}
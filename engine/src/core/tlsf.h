@@ -0,0 +1,83 @@
+#pragma once
+
+#include "defines.h"
+
+#include "platform/threading.h"
+
+// log2 of the number of second-level lists per first-level size class.
+#define TLSF_SL_INDEX_COUNT_LOG2 5
+#define TLSF_SL_INDEX_COUNT (1 << TLSF_SL_INDEX_COUNT_LOG2)
+
+// log2 of the minimum alignment of every block handed out by the allocator, matching the platform allocator.
+#define TLSF_ALIGN_SIZE_LOG2 4
+#define TLSF_ALIGN_SIZE (1 << TLSF_ALIGN_SIZE_LOG2)
+
+// Largest block size class (1 << TLSF_FL_INDEX_MAX bytes) supported by the allocator.
+#define TLSF_FL_INDEX_MAX 40
+#define TLSF_FL_INDEX_SHIFT (TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_FL_INDEX_COUNT (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+// Blocks smaller than this are all kept under the first first-level index.
+#define TLSF_SMALL_BLOCK_SIZE (1 << TLSF_FL_INDEX_SHIFT)
+
+struct tlsf_block;
+struct tlsf_region;
+
+// Fragmentation and usage statistics gathered by walking every region of a TLSF allocator.
+typedef struct tlsf_stats {
+	// Number of regions reserved from the platform.
+	u32 region_count;
+
+	// Total bytes reserved from the platform across all regions.
+	u64 reserved_bytes;
+
+	// Bytes currently handed out as used blocks (payload only).
+	u64 used_bytes;
+
+	// Bytes currently available in free blocks (payload only).
+	u64 free_bytes;
+
+	// Number of free blocks across all regions.
+	u64 free_block_count;
+
+	// Size of the largest single free block.
+	u64 largest_free_block;
+} tlsf_stats;
+
+// Two-Level Segregated Fit allocator managing large regions mapped directly from the OS, not from the C heap.
+// Allocation and free run in O(1) regardless of the number of blocks.
+typedef struct tlsf_allocator {
+	// Bitmap of first-level size classes that contain at least one free block.
+	u64 fl_bitmap;
+
+	// Bitmaps of second-level lists that contain at least one free block, per first-level class.
+	u32 sl_bitmap[TLSF_FL_INDEX_COUNT];
+
+	// Heads of the segregated free lists.
+	struct tlsf_block* blocks[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+
+	// Singly linked list of regions reserved from the platform.
+	struct tlsf_region* regions;
+
+	// Minimum size in bytes of each region reserved when the allocator runs out of memory.
+	u64 region_size;
+
+	// Guards every operation, the allocator may be used from several threads.
+	box_mutex lock;
+} tlsf_allocator;
+
+// Initializes a TLSF allocator and reserves its first region of 'region_size' bytes.
+b8 tlsf_create(u64 region_size, tlsf_allocator* out_allocator);
+
+// Frees every region owned by the allocator. Any blocks still in use become invalid.
+void tlsf_destroy(tlsf_allocator* allocator);
+
+// Allocates 'size' bytes starting on a boundary of 'alignment' bytes (must be a power of two).
+// Reserves a new region from the platform if no free block is large enough.
+void* tlsf_allocate(tlsf_allocator* allocator, u64 size, u64 alignment);
+
+// Returns a block allocated by tlsf_allocate to the allocator.
+void tlsf_free(tlsf_allocator* allocator, void* block);
+
+// Walks every region and fills out usage and fragmentation statistics.
+void tlsf_get_stats(tlsf_allocator* allocator, tlsf_stats* out_stats);
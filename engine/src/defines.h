@@ -154,6 +154,9 @@ STATIC_ASSERT(sizeof(f64) == 8, "Expected f64 to be 8 bytes.");
 
 #define BX_ARRAYSIZE(arr) (sizeof(arr) / sizeof(*arr))
 
+// Alignment used by allocations requested as 'aligned' without an explicit alignment.
+#define BX_CACHE_LINE_SIZE 64
+
 inline static u64 alignment(u64 v, u64 align) {
     return (v + (align - 1)) & ~(align - 1);
 }
@@ -60,15 +60,37 @@ b8 platform_pump_messages(box_platform* plat_state);
 // This function queries the platform-specific window state and returns the platform window should close.
 b8 platform_should_close_window(box_platform* plat_state);
 
-// Platform-level memory allocation.
+// Platform-level memory allocation. Aligned allocations start on a BX_CACHE_LINE_SIZE boundary.
 void* platform_allocate(u64 size, b8 aligned);
 
-// Frees memory allocated by platform_allocate.
+// Platform-level memory allocation starting on a boundary of 'alignment' bytes (must be a power of two).
+void* platform_allocate_aligned(u64 size, u64 alignment);
+
+// Frees memory allocated by platform_allocate or platform_allocate_aligned.
+// 'aligned' must match how the block was allocated.
 void platform_free(const void* block, b8 aligned);
 
+// Reserves 'size' bytes of address space without backing it with memory. Returns NULL on failure.
+void* platform_reserve_memory(u64 size);
+
+// Backs 'size' bytes at 'block' (page aligned, inside a reservation) with zeroed read/write memory.
+b8 platform_commit_memory(void* block, u64 size);
+
+// Releases a whole reservation made by platform_reserve_memory, including committed pages.
+void platform_release_memory(void* block, u64 size);
+
+// Returns the granularity in bytes that memory is committed with.
+u64 platform_get_page_size();
+
+// Returns the number of logical processors available to the process, at least 1.
+u32 platform_get_processor_count();
+
 // Copies memory from source to destination.
 void* platform_copy_memory(void* dest, const void* source, u64 size);
 
+// Copies memory from source to destination, the two ranges may overlap.
+void* platform_move_memory(void* dest, const void* source, u64 size);
+
 // Sets a block of memory to a specific value.
 void* platform_set_memory(void* dest, i32 value, u64 size);
 
@@ -9,22 +9,59 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 
 void* platform_allocate(u64 size, b8 aligned) {
+	if (aligned) return platform_allocate_aligned(size, BX_CACHE_LINE_SIZE);
 	return malloc(size);
 }
 
+void* platform_allocate_aligned(u64 size, u64 alignment) {
+	void* block = NULL;
+	if (posix_memalign(&block, BX_MAX(alignment, sizeof(void*)), size) != 0) 
+		return NULL;
+
+	return block;
+}
+
 void platform_free(const void* block, b8 aligned) {
+	// Blocks from posix_memalign are released with free as well.
 	#pragma GCC diagnostic push
 	#pragma GCC diagnostic ignored "-Wdiscarded-qualifiers"
 	free(block);
 	#pragma GCC diagnostic pop
 }
 
+void* platform_reserve_memory(u64 size) {
+	void* block = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return block == MAP_FAILED ? NULL : block;
+}
+
+b8 platform_commit_memory(void* block, u64 size) {
+	return mprotect(block, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void platform_release_memory(void* block, u64 size) {
+	munmap(block, size);
+}
+
+u64 platform_get_page_size() {
+	return (u64)sysconf(_SC_PAGESIZE);
+}
+
+u32 platform_get_processor_count() {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+
 void* platform_copy_memory(void* dest, const void* source, u64 size) {
 	return memcpy(dest, source, size);
 }
 
+void* platform_move_memory(void* dest, const void* source, u64 size) {
+	return memmove(dest, source, size);
+}
+
 void* platform_set_memory(void* dest, i32 value, u64 size) {
 	return memset(dest, value, size);
 }
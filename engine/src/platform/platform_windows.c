@@ -15,17 +15,55 @@
 #define _CONDITION_EVENT_ALL 1
 
 void* platform_allocate(u64 size, b8 aligned) {
+	if (aligned) return platform_allocate_aligned(size, BX_CACHE_LINE_SIZE);
 	return malloc(size);
 }
 
+void* platform_allocate_aligned(u64 size, u64 alignment) {
+	return _aligned_malloc(size, alignment);
+}
+
 void platform_free(const void* block, b8 aligned) {
+	if (aligned) {
+		_aligned_free((void*)block);
+		return;
+	}
+
 	free(block);
 }
 
+void* platform_reserve_memory(u64 size) {
+	return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+b8 platform_commit_memory(void* block, u64 size) {
+	return VirtualAlloc(block, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+}
+
+void platform_release_memory(void* block, u64 size) {
+	VirtualFree(block, 0, MEM_RELEASE);
+}
+
+u64 platform_get_page_size() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+}
+
+u32 platform_get_processor_count() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return BX_MAX(info.dwNumberOfProcessors, 1);
+}
+
 void* platform_copy_memory(void* dest, const void* source, u64 size) {
 	return memcpy(dest, source, size);
 }
 
+void* platform_move_memory(void* dest, const void* source, u64 size) {
+	return memmove(dest, source, size);
+}
+
 void* platform_set_memory(void* dest, i32 value, u64 size) {
 	return memset(dest, value, size);
 }
@@ -137,3 +137,47 @@ b8 thread_join(box_thread thr, int* res);
 
 // Yield execution to another thread. Permit other threads to run, even if the current thread would ordinarily continue to run.
 void thread_yield();
+
+// Atomics
+// Counters use relaxed ordering, pointer operations are sequentially consistent so they can publish data between threads.
+#if defined(BX_PLATFORM_WINDOWS)
+static inline u64 atomic_load_u64(volatile u64* target) { return (u64)InterlockedCompareExchange64((volatile LONG64*)target, 0, 0); }
+static inline void atomic_store_u64(volatile u64* target, u64 value) { InterlockedExchange64((volatile LONG64*)target, (LONG64)value); }
+static inline u64 atomic_add_u64(volatile u64* target, u64 value) { return (u64)InterlockedExchangeAdd64((volatile LONG64*)target, (LONG64)value) + value; }
+static inline u64 atomic_sub_u64(volatile u64* target, u64 value) { return (u64)InterlockedExchangeAdd64((volatile LONG64*)target, -(LONG64)value) - value; }
+static inline u64 atomic_exchange_u64(volatile u64* target, u64 value) { return (u64)InterlockedExchange64((volatile LONG64*)target, (LONG64)value); }
+
+static inline b8 atomic_compare_exchange_u64(volatile u64* target, u64* expected, u64 desired) {
+    u64 previous = (u64)InterlockedCompareExchange64((volatile LONG64*)target, (LONG64)desired, (LONG64)*expected);
+    if (previous == *expected) return TRUE;
+    *expected = previous;
+    return FALSE;
+}
+
+static inline void* atomic_load_ptr(void* volatile* target) { return InterlockedCompareExchangePointer(target, NULL, NULL); }
+static inline void* atomic_exchange_ptr(void* volatile* target, void* value) { return InterlockedExchangePointer(target, value); }
+
+static inline b8 atomic_compare_exchange_ptr(void* volatile* target, void** expected, void* desired) {
+    void* previous = InterlockedCompareExchangePointer(target, desired, *expected);
+    if (previous == *expected) return TRUE;
+    *expected = previous;
+    return FALSE;
+}
+#else
+static inline u64 atomic_load_u64(volatile u64* target) { return __atomic_load_n(target, __ATOMIC_RELAXED); }
+static inline void atomic_store_u64(volatile u64* target, u64 value) { __atomic_store_n(target, value, __ATOMIC_RELAXED); }
+static inline u64 atomic_add_u64(volatile u64* target, u64 value) { return __atomic_add_fetch(target, value, __ATOMIC_RELAXED); }
+static inline u64 atomic_sub_u64(volatile u64* target, u64 value) { return __atomic_sub_fetch(target, value, __ATOMIC_RELAXED); }
+static inline u64 atomic_exchange_u64(volatile u64* target, u64 value) { return __atomic_exchange_n(target, value, __ATOMIC_RELAXED); }
+
+static inline b8 atomic_compare_exchange_u64(volatile u64* target, u64* expected, u64 desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void* atomic_load_ptr(void* volatile* target) { return __atomic_load_n(target, __ATOMIC_SEQ_CST); }
+static inline void* atomic_exchange_ptr(void* volatile* target, void* value) { return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST); }
+
+static inline b8 atomic_compare_exchange_ptr(void* volatile* target, void** expected, void* desired) {
+    return __atomic_compare_exchange_n(target, expected, desired, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#endif
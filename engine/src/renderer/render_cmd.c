@@ -3,19 +3,32 @@
 
 #include "render_objects.h"
 
+#include "utils/darray.h"
+#include "utils/radix_sort.h"
+
 #if BOX_ENABLE_VALIDATION
 #   define CHECK_FINISHED() if (!cmd) return; if (cmd->finished) { BX_ERROR("Tried to record command into box_rendercmd after ending."); return; }
+#   define CHECK_PRIMARY(what) if (cmd->secondary_target) { BX_ERROR("Tried to record " what " into a secondary box_rendercmd."); return; }
+#   define CHECK_RENDERSTAGE(what, mode) if (!cmd->recording_stage || cmd->recording_stage->pipeline_type != (mode)) { BX_ERROR("Tried to record " what " outside of a matching renderstage in box_rendercmd."); return; }
 #else
 #   define CHECK_FINISHED()
+#   define CHECK_PRIMARY(what)
+#   define CHECK_RENDERSTAGE(what, mode)
 #endif
 
+// Size of each chunk of recorded commands, kept across box_rendercmd_begin for reuse.
+#define RENDERCMD_CHUNK_SIZE (16 * 1024)
+
 rendercmd_payload* add_command(box_rendercmd* cmd, box_renderer_mode mode, rendercmd_payload_type type, u64 payload_size) {
     BX_ASSERT(cmd != NULL && "Invalid arguments passed to add_command");
 
     u64 user_block_size = sizeof(rendercmd_header) + payload_size;
 
     if (freelist_empty(&cmd->buffer)) {
-        freelist_create(user_block_size, MEMORY_TAG_RENDERER, &cmd->buffer);
+        freelist_create_segmented(RENDERCMD_CHUNK_SIZE, MEMORY_TAG_RENDERER, &cmd->buffer);
+
+        // Commands are accessed by index when sorting or splitting a command stream.
+        freelist_enable_index(&cmd->buffer);
     }
 
     void* user_memory = freelist_push(&cmd->buffer, user_block_size, NULL);
@@ -24,38 +37,209 @@ rendercmd_payload* add_command(box_rendercmd* cmd, box_renderer_mode mode, rende
         return NULL;
     }
 
+    // Padding must not change the hash of a static bundle.
+    if (cmd->static_bundle)
+        bzero_memory(user_memory, user_block_size);
+
     rendercmd_header* header = (rendercmd_header*)user_memory;
     header->type = type;
     header->supported_mode = mode;
 
+    // Every fence closes a segment of draws that may be reordered among themselves.
+    if (cmd->sorted && rendercmd_is_sort_fence(type, mode))
+        darray_push(cmd->sort_segments, darray_length(cmd->sort_entries));
+
     // user_memory points at rendercmd_header
     return payload_size > 0 ? (rendercmd_payload*)((u8*)user_memory + sizeof(rendercmd_header)) : NULL;
 }
 
+b8 rendercmd_is_sort_fence(rendercmd_payload_type type, box_renderer_mode mode) {
+    switch (type) {
+    case RENDERCMD_BIND_RENDERTARGET:
+    case RENDERCMD_MEMORY_BARRIER:
+    case RENDERCMD_EXECUTE_SECONDARY:
+    case RENDERCMD_END:
+        return TRUE;
+
+    case RENDERCMD_BEGIN_RENDERSTAGE:
+        return mode != RENDERER_MODE_GRAPHICS;
+
+    default:
+        return FALSE;
+    }
+}
+
+b8 rendercmd_is_draw_state(rendercmd_payload_type type) {
+    return type == RENDERCMD_PUSH_CONSTANTS || type == RENDERCMD_BIND_UNIFORM || type == RENDERCMD_BIND_BUFFERS;
+}
+
+// Remembers the first draw state command since the last draw of a sorted graphics renderstage.
+void record_draw_state(box_rendercmd* cmd) {
+    if (cmd->sorted && cmd->recording_stage->pipeline_type == RENDERER_MODE_GRAPHICS && cmd->draw_state_command == UINT64_MAX)
+        cmd->draw_state_command = freelist_block_count(&cmd->buffer) - 1;
+}
+
+void record_sort_entry(box_rendercmd* cmd) {
+    box_rendercmd_sort_entry entry = {};
+    entry.key = cmd->sort_key;
+    entry.renderstage = cmd->recording_stage;
+    entry.command = freelist_block_count(&cmd->buffer) - 1;
+    entry.first_command = cmd->draw_state_command != UINT64_MAX ? cmd->draw_state_command : entry.command;
+    darray_push(cmd->sort_entries, entry);
+
+    cmd->draw_state_command = UINT64_MAX;
+}
+
+// Sorts every segment of draws by key and counts the renderstage binds left over.
+void sort_commands(box_rendercmd* cmd) {
+    u64 entry_count = darray_length(cmd->sort_entries);
+    darray_clear(cmd->sort_scratch);
+    darray_reserve_more(cmd->sort_scratch, entry_count);
+
+    cmd->sorted_binds = 0;
+
+    u64 first = 0;
+    for (u64 i = 0; i < darray_length(cmd->sort_segments); ++i) {
+        u64 last = cmd->sort_segments[i];
+        radix_sort_by_key(cmd->sort_entries + first, cmd->sort_scratch, last - first, sizeof(box_rendercmd_sort_entry));
+
+        // Playback ends the bound renderstage at every fence.
+        box_renderstage* bound = NULL;
+        for (u64 j = first; j < last; ++j) {
+            if (cmd->sort_entries[j].renderstage == bound) continue;
+
+            bound = cmd->sort_entries[j].renderstage;
+            cmd->sorted_binds++;
+        }
+
+        first = last;
+    }
+}
+
+// FNV-1a over every recorded block, headers included.
+u64 hash_commands(box_rendercmd* cmd) {
+    u64 hash = 0xcbf29ce484222325ULL;
+
+    u8* cursor = 0;
+    while (freelist_next_block(&cmd->buffer, &cursor)) {
+        u64 size = freelist_block_size(&cmd->buffer, cursor);
+        for (u64 i = 0; i < size; ++i) {
+            hash ^= cursor[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    return hash;
+}
+
+rendercmd_payload* get_command_payload(box_rendercmd* cmd, u64 index) {
+    return (rendercmd_payload*)((u8*)freelist_get(&cmd->buffer, index) + sizeof(rendercmd_header));
+}
+
 void box_rendercmd_begin(box_rendercmd* cmd) {
     BX_ASSERT(cmd != NULL && "Invalid arguments passed to box_rendercmd_begin");
+    // Recycles the chunks of the last recording, payload pointers handed out before are invalidated.
     if (!freelist_empty(&cmd->buffer))
         freelist_reset(&cmd->buffer, FALSE, FALSE);
 
     cmd->finished = FALSE;
+    cmd->inline_contents = FALSE;
+    cmd->rendertarget_command = UINT64_MAX;
+    cmd->secondary_target = NULL;
+    cmd->internal_data = NULL;
+    cmd->static_bundle = FALSE;
+    cmd->content_hash = 0;
+
+    cmd->sorted = FALSE;
+    cmd->sort_key = 0;
+    cmd->draw_state_command = UINT64_MAX;
+    cmd->replaced_buffers = 0;
+    cmd->recording_stage = NULL;
+    cmd->recorded_binds = 0;
+    cmd->sorted_binds = 0;
+}
+
+void box_rendercmd_begin_sorted(box_rendercmd* cmd) {
+    BX_ASSERT(cmd != NULL && "Invalid arguments passed to box_rendercmd_begin_sorted");
+    box_rendercmd_begin(cmd);
+
+    if (!cmd->sort_entries) {
+        cmd->sort_entries = darray_create(box_rendercmd_sort_entry, MEMORY_TAG_RENDERER);
+        cmd->sort_segments = darray_create(u64, MEMORY_TAG_RENDERER);
+        cmd->sort_scratch = darray_create(box_rendercmd_sort_entry, MEMORY_TAG_RENDERER);
+    }
+
+    darray_clear(cmd->sort_entries);
+    darray_clear(cmd->sort_segments);
+    cmd->sorted = TRUE;
+}
+
+void box_rendercmd_set_sort_key(box_rendercmd* cmd, u64 key) {
+    CHECK_FINISHED();
+
+#if BOX_ENABLE_VALIDATION
+    if (!cmd->sorted) {
+        BX_ERROR("Tried to set a sort key in a box_rendercmd not begun with box_rendercmd_begin_sorted.");
+        return;
+    }
+#endif
+
+    cmd->sort_key = key;
+}
+
+void box_rendercmd_begin_secondary(box_rendercmd* cmd, box_rendertarget* rendertarget) {
+    BX_ASSERT(cmd != NULL && rendertarget != NULL && "Invalid arguments passed to box_rendercmd_begin_secondary");
+    box_rendercmd_begin(cmd);
+    cmd->secondary_target = rendertarget;
+}
+
+void box_rendercmd_begin_static(box_rendercmd* cmd, box_rendertarget* rendertarget) {
+    BX_ASSERT(cmd != NULL && rendertarget != NULL && "Invalid arguments passed to box_rendercmd_begin_static");
+
+    // The backend translation of the last recording is found again through it if the commands turn out the same.
+    void* internal_data = cmd->static_bundle ? cmd->internal_data : NULL;
+
+    box_rendercmd_begin_secondary(cmd, rendertarget);
+    cmd->static_bundle = TRUE;
+    cmd->internal_data = internal_data;
 }
 
 void box_rendercmd_destroy(box_rendercmd* cmd) {
     BX_ASSERT(cmd != NULL && "Invalid arguments passed to box_rendercmd_end");
     freelist_destroy(&cmd->buffer);
+
+    if (cmd->sort_entries) {
+        darray_destroy(cmd->sort_entries);
+        darray_destroy(cmd->sort_segments);
+        darray_destroy(cmd->sort_scratch);
+    }
+
     bzero_memory(cmd, sizeof(box_rendercmd));
 }
 
 void box_rendercmd_bind_rendertarget(box_rendercmd* cmd, box_rendertarget* rendertarget) {
     CHECK_FINISHED();
+    CHECK_PRIMARY("a rendertarget bind");
+
+#if BOX_ENABLE_VALIDATION
+    if (cmd->rendertarget_command != UINT64_MAX) {
+        BX_ERROR("Tried to bind rendertarget twice in box_rendercmd.");
+        return;
+    }
+#endif
 
     rendercmd_payload* payload;
     payload = add_command(cmd, RENDERER_MODE_GRAPHICS, RENDERCMD_BIND_RENDERTARGET, sizeof(payload->bind_rendertarget));
     payload->bind_rendertarget.rendertarget = rendertarget;
+    payload->bind_rendertarget.secondary_contents = FALSE;
+
+    // Executing secondary command buffers later marks this command, which is found again by index.
+    cmd->rendertarget_command = freelist_block_count(&cmd->buffer) - 1;
 }
 
 void box_rendercmd_memory_barrier(box_rendercmd* cmd, box_renderstage* src_renderstage, box_renderstage* dst_renderstage, box_access_flags src_access, box_access_flags dst_access) {
     CHECK_FINISHED();
+    CHECK_PRIMARY("a memory barrier");
 
     rendercmd_payload* payload;
     payload = add_command(cmd, 0, RENDERCMD_MEMORY_BARRIER, sizeof(payload->memory_barrier));
@@ -68,48 +252,359 @@ void box_rendercmd_memory_barrier(box_rendercmd* cmd, box_renderstage* src_rende
 void box_rendercmd_begin_renderstage(box_rendercmd* cmd, box_renderstage* renderstage) {
     CHECK_FINISHED();
 
+#if BOX_ENABLE_VALIDATION
+    if (cmd->recording_stage) {
+        BX_ERROR("Tried to begin renderstage twice in box_rendercmd.");
+        return;
+    }
+
+    if (cmd->secondary_target && renderstage->pipeline_type != RENDERER_MODE_GRAPHICS) {
+        BX_ERROR("Tried to begin a non graphics renderstage in a secondary box_rendercmd.");
+        return;
+    }
+
+    if (!cmd->secondary_target && cmd->rendertarget_command != UINT64_MAX && 
+        get_command_payload(cmd, cmd->rendertarget_command)->bind_rendertarget.secondary_contents) {
+        BX_ERROR("Tried to begin a renderstage in a rendertarget filled by secondary box_rendercmds.");
+        return;
+    }
+#endif
+
+    if (!cmd->secondary_target && cmd->rendertarget_command != UINT64_MAX)
+        cmd->inline_contents = TRUE;
+
+    if (renderstage->pipeline_type == RENDERER_MODE_GRAPHICS)
+        cmd->recorded_binds++;
+
+    cmd->recording_stage = renderstage;
+
     rendercmd_payload* payload;
     payload = add_command(cmd, renderstage->pipeline_type, RENDERCMD_BEGIN_RENDERSTAGE, sizeof(payload->begin_renderstage));
     payload->begin_renderstage.renderstage = renderstage;
+
+    // Playback may skip ending and beginning the same renderstage, so replaced buffers are put back explicitly.
+    if (cmd->replaced_buffers && renderstage->pipeline_type == RENDERER_MODE_GRAPHICS) {
+        u32 bindings = cmd->replaced_buffers & ((1u << BOX_MAX_VERTEX_BINDINGS) - 1);
+        if (!bindings) bindings = 1; // Only the index buffer, put back along with the first binding.
+
+        for (u32 i = 0; i < BOX_MAX_VERTEX_BINDINGS; ++i) {
+            if (bindings & (1u << i))
+                box_rendercmd_bind_buffers(cmd, i, NULL, 0, NULL, 0);
+        }
+    }
+}
+
+#if BOX_ENABLE_VALIDATION
+// Checks that 'buffer' has the usage needed to be bound and 'offset' lies inside of it.
+b8 validate_bound_buffer(box_renderbuffer* buffer, box_renderbuffer_usage usage, u64 offset) {
+    if (!buffer) return offset == 0;
+    if ((usage & BOX_RENDERBUFFER_USAGE_INDEX) && offset % box_index_type_size(buffer->index_type) != 0) return FALSE;
+    return (buffer->usage & usage) && offset < buffer->buffer_size;
+}
+#endif
+
+void box_rendercmd_bind_buffers(box_rendercmd* cmd, u32 vertex_binding, box_renderbuffer* vertex_buffer, u64 vertex_offset, box_renderbuffer* index_buffer, u64 index_offset) {
+    CHECK_FINISHED();
+    CHECK_RENDERSTAGE("a buffer bind", RENDERER_MODE_GRAPHICS);
+
+#if BOX_ENABLE_VALIDATION
+    if (vertex_binding >= BOX_MAX_VERTEX_BINDINGS) {
+        BX_ERROR("Tried to bind a vertex buffer to binding %u, renderstages have at most %u vertex bindings.", vertex_binding, BOX_MAX_VERTEX_BINDINGS);
+        return;
+    }
+
+    if (!validate_bound_buffer(vertex_buffer, BOX_RENDERBUFFER_USAGE_VERTEX, vertex_offset) ||
+        !validate_bound_buffer(index_buffer, BOX_RENDERBUFFER_USAGE_INDEX, index_offset)) {
+        BX_ERROR("Tried to bind a renderbuffer without vertex or index usage, or at an offset outside of it or not aligned to its indices.");
+        return;
+    }
+#endif
+
+    rendercmd_payload* payload;
+    payload = add_command(cmd, 0, RENDERCMD_BIND_BUFFERS, sizeof(payload->bind_buffers));
+    payload->bind_buffers.vertex_binding = vertex_binding;
+    payload->bind_buffers.vertex_buffer = vertex_buffer;
+    payload->bind_buffers.vertex_offset = vertex_offset;
+    payload->bind_buffers.index_buffer = index_buffer;
+    payload->bind_buffers.index_offset = index_offset;
+
+    u32 binding_bit = 1u << vertex_binding;
+    u32 index_bit = 1u << BOX_MAX_VERTEX_BINDINGS;
+    cmd->replaced_buffers &= ~(binding_bit | index_bit);
+    if (vertex_buffer) cmd->replaced_buffers |= binding_bit;
+    if (index_buffer) cmd->replaced_buffers |= index_bit;
+    record_draw_state(cmd);
+}
+
+void box_rendercmd_push_constants(box_rendercmd* cmd, box_shader_stage_type stage, u32 offset, u32 size, const void* data) {
+    CHECK_FINISHED();
+
+#if BOX_ENABLE_VALIDATION
+    if (!cmd->recording_stage) {
+        BX_ERROR("Tried to record push constants outside of a renderstage in box_rendercmd.");
+        return;
+    }
+
+    if (!data || size == 0 || offset % 4 != 0 || size % 4 != 0) {
+        BX_ERROR("Push constants need data and an offset and size that are multiples of 4 (offset %u, size %u).", offset, size);
+        return;
+    }
+
+    // Every range touched by the write must hold all of it, as the backend writes it for each of their stages.
+    b8 stage_found = FALSE;
+    box_push_constant_range* ranges = cmd->recording_stage->push_constants;
+    for (u32 i = 0; i < darray_length(ranges); ++i) {
+        if (offset >= ranges[i].offset + ranges[i].size || offset + size <= ranges[i].offset) continue;
+
+        if (offset < ranges[i].offset || offset + size > ranges[i].offset + ranges[i].size) {
+            BX_ERROR("Push constants at offset %u (%u bytes) only partially cover the range of shader stage %u.", offset, size, ranges[i].stage_type);
+            return;
+        }
+
+        if (ranges[i].stage_type == stage) stage_found = TRUE;
+    }
+
+    if (!stage_found) {
+        BX_ERROR("Push constants at offset %u (%u bytes) are outside of the push constant range of shader stage %u.", offset, size, stage);
+        return;
+    }
+#endif
+
+    rendercmd_payload* payload;
+    payload = add_command(cmd, 0, RENDERCMD_PUSH_CONSTANTS, sizeof(payload->push_constants) + size);
+    payload->push_constants.offset = offset;
+    payload->push_constants.size = size;
+    payload->push_constants.stage_type = stage;
+    bcopy_memory((void*)RENDERCMD_PUSH_CONSTANT_DATA(payload), data, size);
+
+    // Sorted draws are moved away from the commands around them, so they take their push constants along.
+    record_draw_state(cmd);
+}
+
+void box_rendercmd_bind_uniform(box_rendercmd* cmd, u32 binding, const void* data, u32 size) {
+    CHECK_FINISHED();
+
+#if BOX_ENABLE_VALIDATION
+    if (!cmd->recording_stage) {
+        BX_ERROR("Tried to bind uniform data outside of a renderstage in box_rendercmd.");
+        return;
+    }
+
+    box_descriptor_desc* descriptor = NULL;
+    for (u32 i = 0; i < darray_length(cmd->recording_stage->descriptors); ++i) {
+        if (cmd->recording_stage->descriptors[i].binding == binding) descriptor = &cmd->recording_stage->descriptors[i];
+    }
+
+    if (!descriptor || descriptor->descriptor_type != BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+        BX_ERROR("Tried to bind uniform data to binding %u, which is not a dynamic uniform buffer of the renderstage.", binding);
+        return;
+    }
+
+    if (!data || size == 0 || size > descriptor->uniform_size) {
+        BX_ERROR("Uniform data of %u bytes does not fit the %u byte uniform buffer at binding %u.", size, descriptor->uniform_size, binding);
+        return;
+    }
+#endif
+
+    rendercmd_payload* payload;
+    payload = add_command(cmd, 0, RENDERCMD_BIND_UNIFORM, sizeof(payload->bind_uniform) + size);
+    payload->bind_uniform.binding = binding;
+    payload->bind_uniform.size = size;
+    bcopy_memory((void*)RENDERCMD_UNIFORM_DATA(payload), data, size);
+
+    record_draw_state(cmd);
 }
 
 void box_rendercmd_draw(box_rendercmd* cmd, u32 vertex_count, u32 instance_count) {
+    box_rendercmd_draw_range(cmd, vertex_count, instance_count, 0, 0);
+}
+
+void box_rendercmd_draw_indexed(box_rendercmd* cmd, u32 index_count, u32 instance_count) {
+    box_rendercmd_draw_indexed_range(cmd, index_count, instance_count, 0, 0, 0);
+}
+
+void box_rendercmd_draw_range(box_rendercmd* cmd, u32 vertex_count, u32 instance_count, u32 first_vertex, u32 first_instance) {
     CHECK_FINISHED();
+    CHECK_RENDERSTAGE("a draw call", RENDERER_MODE_GRAPHICS);
 
     rendercmd_payload* payload;
     payload = add_command(cmd, RENDERER_MODE_GRAPHICS, RENDERCMD_DRAW, sizeof(payload->draw));
     payload->draw.vertex_count = vertex_count;
     payload->draw.instance_count = instance_count;
+    payload->draw.first_vertex = first_vertex;
+    payload->draw.first_instance = first_instance;
+
+    if (cmd->sorted) record_sort_entry(cmd);
 }
 
-void box_rendercmd_draw_indexed(box_rendercmd* cmd, u32 index_count, u32 instance_count) {
+void box_rendercmd_draw_indexed_range(box_rendercmd* cmd, u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance) {
     CHECK_FINISHED();
+    CHECK_RENDERSTAGE("a draw call", RENDERER_MODE_GRAPHICS);
 
     rendercmd_payload* payload;
     payload = add_command(cmd, RENDERER_MODE_GRAPHICS, RENDERCMD_DRAW_INDEXED, sizeof(payload->draw_indexed));
     payload->draw_indexed.index_count = index_count;
     payload->draw_indexed.instance_count = instance_count;
+    payload->draw_indexed.first_index = first_index;
+    payload->draw_indexed.vertex_offset = vertex_offset;
+    payload->draw_indexed.first_instance = first_instance;
+
+    if (cmd->sorted) record_sort_entry(cmd);
+}
+
+#if BOX_ENABLE_VALIDATION
+// Checks that 'size' bytes of indirect arguments can be read at 'offset' of the buffer.
+b8 validate_indirect_buffer(box_renderbuffer* buffer, u64 offset, u64 size) {
+    if (!buffer || !(buffer->usage & BOX_RENDERBUFFER_USAGE_INDIRECT)) {
+        BX_ERROR("Tried to read indirect arguments from a renderbuffer created without BOX_RENDERBUFFER_USAGE_INDIRECT.");
+        return FALSE;
+    }
+
+    if (offset % 4 != 0 || offset + size > buffer->buffer_size) {
+        BX_ERROR("Indirect arguments at offset %llu (%llu bytes) are misaligned or out of range of a %llu byte renderbuffer.", offset, size, buffer->buffer_size);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+#endif
+
+// Records an indirect draw of either kind, 'args_size' being the size of the arguments of a single draw.
+void add_draw_indirect(box_rendercmd* cmd, rendercmd_payload_type type, u64 args_size, box_renderbuffer* buffer, u64 offset, u32 max_draw_count, u32 stride, box_renderbuffer* count_buffer, u64 count_offset) {
+    CHECK_FINISHED();
+    CHECK_RENDERSTAGE("an indirect draw call", RENDERER_MODE_GRAPHICS);
+
+    // Checked in every build, the backend can not replay the draw without the feature. Stages that were not
+    // created by a backend have no capabilities and can not read the draw count from a buffer either.
+    box_renderstage* stage = cmd->recording_stage;
+    if (count_buffer && (!stage || !stage->capabilities || !stage->capabilities->draw_indirect_count)) {
+        BX_ERROR("Tried to record an indirect draw with a count buffer, the device does not support reading the draw count from a buffer.");
+        return;
+    }
+
+#if BOX_ENABLE_VALIDATION
+    if ((max_draw_count > 1 || count_buffer) && (stride < args_size || stride % 4 != 0)) {
+        BX_ERROR("Indirect draw stride of %u bytes must be a multiple of 4 holding at least one draw (%llu bytes).", stride, args_size);
+        return;
+    }
+
+    u64 range = max_draw_count > 0 ? (u64)(max_draw_count - 1) * stride + args_size : 0;
+    if (!validate_indirect_buffer(buffer, offset, range)) return;
+    if (count_buffer && !validate_indirect_buffer(count_buffer, count_offset, sizeof(u32))) return;
+#endif
+
+    rendercmd_payload* payload;
+    payload = add_command(cmd, RENDERER_MODE_GRAPHICS, type, sizeof(payload->draw_indirect));
+    payload->draw_indirect.buffer = buffer;
+    payload->draw_indirect.offset = offset;
+    payload->draw_indirect.count_buffer = count_buffer;
+    payload->draw_indirect.count_offset = count_offset;
+    payload->draw_indirect.draw_count = max_draw_count;
+    payload->draw_indirect.stride = stride;
+
+    if (cmd->sorted) record_sort_entry(cmd);
+}
+
+void box_rendercmd_draw_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset, u32 max_draw_count, u32 stride, box_renderbuffer* count_buffer, u64 count_offset) {
+    add_draw_indirect(cmd, RENDERCMD_DRAW_INDIRECT, sizeof(box_draw_indirect_args), buffer, offset, max_draw_count, stride, count_buffer, count_offset);
+}
+
+void box_rendercmd_draw_indexed_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset, u32 max_draw_count, u32 stride, box_renderbuffer* count_buffer, u64 count_offset) {
+    add_draw_indirect(cmd, RENDERCMD_DRAW_INDEXED_INDIRECT, sizeof(box_draw_indexed_indirect_args), buffer, offset, max_draw_count, stride, count_buffer, count_offset);
 }
 
 void box_rendercmd_dispatch(box_rendercmd* cmd, u32 group_size_x, u32 group_size_y, u32 group_size_z) {
     CHECK_FINISHED();
+    CHECK_PRIMARY("a dispatch");
+    CHECK_RENDERSTAGE("a dispatch", RENDERER_MODE_COMPUTE);
 
     rendercmd_payload* payload;
-    payload = add_command(cmd, RENDERER_MODE_COMPUTE, RENDERCMD_DISPATCH, sizeof(payload->draw));
+    payload = add_command(cmd, RENDERER_MODE_COMPUTE, RENDERCMD_DISPATCH, sizeof(payload->dispatch));
     payload->dispatch.group_size.x = group_size_x;
     payload->dispatch.group_size.y = group_size_y;
     payload->dispatch.group_size.z = group_size_z;
 }
 
+void box_rendercmd_dispatch_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset) {
+    CHECK_FINISHED();
+    CHECK_PRIMARY("an indirect dispatch");
+    CHECK_RENDERSTAGE("an indirect dispatch", RENDERER_MODE_COMPUTE);
+
+#if BOX_ENABLE_VALIDATION
+    if (!validate_indirect_buffer(buffer, offset, sizeof(box_dispatch_indirect_args))) return;
+#endif
+
+    rendercmd_payload* payload;
+    payload = add_command(cmd, RENDERER_MODE_COMPUTE, RENDERCMD_DISPATCH_INDIRECT, sizeof(payload->dispatch_indirect));
+    payload->dispatch_indirect.buffer = buffer;
+    payload->dispatch_indirect.offset = offset;
+}
+
+void box_rendercmd_execute_secondary(box_rendercmd* cmd, box_rendercmd** secondaries, u32 secondary_count) {
+    CHECK_FINISHED();
+    CHECK_PRIMARY("secondary box_rendercmds");
+    BX_ASSERT((secondaries != NULL || secondary_count == 0) && "Invalid arguments passed to box_rendercmd_execute_secondary");
+
+#if BOX_ENABLE_VALIDATION
+    if (cmd->rendertarget_command == UINT64_MAX) {
+        BX_ERROR("Tried to execute secondary box_rendercmds without a bound rendertarget.");
+        return;
+    }
+
+    if (cmd->inline_contents || cmd->recording_stage) {
+        BX_ERROR("Tried to execute secondary box_rendercmds in a rendertarget that already has renderstages recorded.");
+        return;
+    }
+
+    box_rendertarget* rendertarget = get_command_payload(cmd, cmd->rendertarget_command)->bind_rendertarget.rendertarget;
+    for (u32 i = 0; i < secondary_count; ++i) {
+        if (!secondaries[i]->finished || secondaries[i]->secondary_target != rendertarget) {
+            BX_ERROR("Tried to execute a secondary box_rendercmd that is unfinished or recorded for another rendertarget.");
+            return;
+        }
+    }
+#endif
+
+    // The list is copied inline, so merge order is fixed at record time.
+    rendercmd_payload* payload;
+    u64 list_size = sizeof(box_rendercmd*) * secondary_count;
+    payload = add_command(cmd, RENDERER_MODE_GRAPHICS, RENDERCMD_EXECUTE_SECONDARY, sizeof(payload->execute_secondary) + list_size);
+    payload->execute_secondary.rendercmd_count = secondary_count;
+    if (list_size > 0) bcopy_memory(RENDERCMD_SECONDARY_LIST(payload), secondaries, list_size);
+
+    get_command_payload(cmd, cmd->rendertarget_command)->bind_rendertarget.secondary_contents = TRUE;
+}
+
 void box_rendercmd_end_renderstage(box_rendercmd* cmd) {
     CHECK_FINISHED();
 
+#if BOX_ENABLE_VALIDATION
+    if (!cmd->recording_stage) {
+        BX_ERROR("Tried to end renderstage twice in box_rendercmd.");
+        return;
+    }
+#endif
+
     add_command(cmd, 0, RENDERCMD_END_RENDERSTAGE, 0);
+    cmd->recording_stage = NULL;
+    cmd->draw_state_command = UINT64_MAX;
 }
 
 void box_rendercmd_end(box_rendercmd* cmd) {
     CHECK_FINISHED();
 
+#if BOX_ENABLE_VALIDATION
+    if (cmd->recording_stage) {
+        BX_ERROR("Tried to end box_rendercmd before ending its renderstage.");
+        return;
+    }
+#endif
+
     add_command(cmd, 0, RENDERCMD_END, 0);
     cmd->finished = TRUE;
+
+    if (cmd->sorted) sort_commands(cmd);
+    else cmd->sorted_binds = cmd->recorded_binds;
+
+    if (cmd->static_bundle) cmd->content_hash = hash_commands(cmd);
 }
\ No newline at end of file
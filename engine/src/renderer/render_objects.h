@@ -15,6 +15,9 @@ typedef struct box_renderbuffer_config {
 
     /** @brief Total size of the buffer in bytes. */
     u64 buffer_size;
+
+    /** @brief Type of the indices held by a buffer with BOX_RENDERBUFFER_USAGE_INDEX. */
+    box_index_type index_type;
 } box_renderbuffer_config;
 
 /**
@@ -26,6 +29,12 @@ typedef struct box_renderbuffer {
     /** @brief Total size of the buffer in bytes. */
     u64 buffer_size;
 
+    /** @brief Usage the buffer was created with. */
+    box_renderbuffer_usage usage;
+
+    /** @brief Type of the indices held by the buffer, if it is an index buffer. */
+    box_index_type index_type;
+
     /** @brief Backend-specific buffer state/handle. */
     void* internal_data;
 } box_renderbuffer;
@@ -51,10 +60,33 @@ typedef struct box_renderstage_layout {
     /** @brief Descriptor binding descriptions used by the pipeline. */
 	box_descriptor_desc* descriptors;
 
+    /** @brief Number of push constant ranges. */
+    u32 push_constant_count;
+
+    /** @brief Push constant ranges, written with box_rendercmd_push_constants. */
+    box_push_constant_range* push_constants;
+
     /** @brief Shader stages indexed by box_shader_stage_type. */
     box_shader_src stages[BOX_SHADER_STAGE_TYPE_MAX];
 } box_renderstage_layout;
 
+/**
+ * @brief Describes a vertex buffer binding and the attributes read from it.
+ */
+typedef struct box_vertex_binding {
+    /** @brief Number of attributes read from the binding. */
+    u32 attribute_count;
+
+    /** @brief Attribute formats packed in order, their sizes adding up to the stride of the binding. */
+    box_render_format* attributes;
+
+    /** @brief Whether the binding advances per vertex or per instance. */
+    box_vertex_input_rate input_rate;
+
+    /** @brief Optional vertex buffer bound to the binding with the render stage. */
+    box_renderbuffer* buffer;
+} box_vertex_binding;
+
 /**
  * @brief Configuration for a graphics render stage.
  *
@@ -71,6 +103,16 @@ typedef struct box_graphicstage_config {
     /** @brief Optional vertex buffer bound to this render stage. */
     box_renderbuffer* vertex_buffer;
 
+    /**
+     * @brief Number of vertex bindings in @ref vertex_bindings.
+     *
+     * When 0, @ref vertex_attributes and @ref vertex_buffer describe a single per-vertex binding.
+     */
+    u32 vertex_binding_count;
+
+    /** @brief Vertex bindings in binding order, attribute locations count up across all of them. */
+    box_vertex_binding* vertex_bindings;
+
     /** @brief Optional index buffer bound to this render stage. */
     box_renderbuffer* index_buffer;
 
@@ -99,6 +141,12 @@ typedef struct box_renderstage {
 
     box_descriptor_desc* descriptors;
 
+    /** @brief darray of the push constant ranges of the layout. */
+    box_push_constant_range* push_constants;
+
+    /** @brief Capabilities of the backend that created the renderstage, checked when commands are recorded into it. */
+    const box_renderer_capabilities* capabilities;
+
     /** @brief Backend-specific pipeline or program data. */
     void* internal_data;
 } box_renderstage;
@@ -257,17 +305,129 @@ typedef struct box_update_descriptors {
     };
 } box_update_descriptors;
 
+/**
+ * @brief Arguments of a single indirect draw, as read from an indirect renderbuffer.
+ */
+typedef struct box_draw_indirect_args {
+    u32 vertex_count;
+    u32 instance_count;
+    u32 first_vertex;
+    u32 first_instance;
+} box_draw_indirect_args;
+
+/**
+ * @brief Arguments of a single indexed indirect draw, as read from an indirect renderbuffer.
+ */
+typedef struct box_draw_indexed_indirect_args {
+    u32 index_count;
+    u32 instance_count;
+    u32 first_index;
+    i32 vertex_offset;
+    u32 first_instance;
+} box_draw_indexed_indirect_args;
+
+/**
+ * @brief Arguments of an indirect compute dispatch, as read from an indirect renderbuffer.
+ */
+typedef struct box_dispatch_indirect_args {
+    u32 group_count_x;
+    u32 group_count_y;
+    u32 group_count_z;
+} box_dispatch_indirect_args;
+
+/**
+ * @brief Builds a draw sort key, most significant field first.
+ *
+ * Layout: 8 bits rendertarget, 16 bits renderstage, 16 bits descriptor set, 24 bits depth.
+ * Draws with equal keys keep their recording order.
+ */
+#define BOX_RENDERCMD_SORT_KEY(rendertarget, renderstage, descriptor, depth) \
+    ((((u64)(rendertarget) & 0xFF)   << 56) | \
+     (((u64)(renderstage)  & 0xFFFF) << 40) | \
+     (((u64)(descriptor)   & 0xFFFF) << 24) | \
+     (((u64)(depth)        & 0xFFFFFF)))
+
+/**
+ * @brief Draw recorded into a sorted command buffer.
+ */
+typedef struct box_rendercmd_sort_entry {
+    /** @brief Sort key, must stay the first member. */
+    u64 key;
+
+    /** @brief Renderstage the draw was recorded in. */
+    box_renderstage* renderstage;
+
+    /** @brief Index of the draw command within the command buffer. */
+    u64 command;
+
+    /** @brief Index of the first draw state command replayed before the draw, @ref command if there are none. */
+    u64 first_command;
+} box_rendercmd_sort_entry;
+
 /**
  * @brief Render command buffer.
  *
  * Collects rendering commands for deferred execution
- * by the renderer.
+ * by the renderer. Different command buffers may be recorded
+ * on different threads at the same time, a single command
+ * buffer must only be recorded by one thread at a time.
  */
 typedef struct box_rendercmd {
     /** @brief True if no further commands may be written. */
     b8 finished;
 
-    /** @brief Allocator backing the render command buffer. */
+    /** @brief True once a renderstage was begun inside the bound rendertarget of a primary command buffer. */
+    b8 inline_contents;
+
+    /** @brief Index of the command binding the rendertarget, UINT64_MAX while none is bound. */
+    u64 rendertarget_command;
+
+    /** @brief Rendertarget a secondary command buffer draws into, NULL for primary command buffers. */
+    box_rendertarget* secondary_target;
+
+    /** @brief Backend translation of a prepared secondary command buffer, only valid within the frame it was prepared in. */
+    void* internal_data;
+
+    /** @brief True if the backend keeps the translation of this secondary command buffer across frames. */
+    b8 static_bundle;
+
+    /** @brief Hash of every recorded command of a finished static bundle. */
+    u64 content_hash;
+
+    /** @brief True if draws are reordered by their sort key when the command buffer ends. */
+    b8 sorted;
+
+    /** @brief Sort key given to draws recorded from now on. */
+    u64 sort_key;
+
+    /** @brief Renderstage being recorded, NULL outside of renderstages. */
+    box_renderstage* recording_stage;
+
+    /** @brief darray of every draw of a sorted command buffer, ordered by key within each segment after ending. */
+    box_rendercmd_sort_entry* sort_entries;
+
+    /** @brief darray of entry counts at each sort fence, closing one segment of @ref sort_entries each. */
+    u64* sort_segments;
+
+    /** @brief darray used as scratch memory by the sort, kept to avoid reallocating every frame. */
+    box_rendercmd_sort_entry* sort_scratch;
+
+    /** @brief Index of the first draw state command since the last draw of a sorted command buffer, UINT64_MAX if none. */
+    u64 draw_state_command;
+
+    /**
+     * @brief Bit per vertex binding whose buffer box_rendercmd_bind_buffers replaced, undone when the next renderstage begins.
+     * Bit BOX_MAX_VERTEX_BINDINGS stands for the index buffer.
+     */
+    u32 replaced_buffers;
+
+    /** @brief Graphics renderstage binds as recorded. */
+    u32 recorded_binds;
+
+    /** @brief Graphics renderstage binds left after sorting, equal to @ref recorded_binds for unsorted command buffers. */
+    u32 sorted_binds;
+
+    /** @brief Segmented allocator backing the render command buffer, payloads never move until the next begin. */
     freelist buffer;
 } box_rendercmd;
 
@@ -280,6 +440,55 @@ typedef struct box_rendercmd {
  */
 void box_rendercmd_begin(box_rendercmd* cmd);
 
+/**
+ * @brief Resets the command buffer as a secondary command buffer.
+ *
+ * Secondary command buffers only hold renderstages and draw calls,
+ * they are executed inside @p rendertarget by a primary command buffer
+ * through box_rendercmd_execute_secondary. This allows disjoint parts
+ * of a frame to be recorded on several threads.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param rendertarget Render target the commands will draw into.
+ */
+void box_rendercmd_begin_secondary(box_rendercmd* cmd, box_rendertarget* rendertarget);
+
+/**
+ * @brief Resets the command buffer as a static bundle.
+ *
+ * A static bundle is a secondary command buffer whose backend translation
+ * is kept across frames. When executed, it is only translated again if its
+ * recorded commands hash differently or a renderstage, renderbuffer or
+ * rendertarget it uses was recreated or had its descriptors updated since.
+ * Recording the same commands again every frame is cheap, not recording
+ * the bundle again at all is cheaper still. A static bundle may be
+ * executed at most once per frame.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param rendertarget Render target the commands will draw into.
+ */
+void box_rendercmd_begin_static(box_rendercmd* cmd, box_rendertarget* rendertarget);
+
+/**
+ * @brief Resets the command buffer with draw sorting enabled.
+ *
+ * Draws are reordered by the key set through box_rendercmd_set_sort_key
+ * when the command buffer ends, so draws sharing a renderstage end up in
+ * a single bind. Memory barriers, rendertarget binds, secondary command
+ * buffers and compute renderstages act as fences no draw is moved across.
+ *
+ * @param cmd Pointer to the command buffer.
+ */
+void box_rendercmd_begin_sorted(box_rendercmd* cmd);
+
+/**
+ * @brief Sets the sort key of draws recorded from now on.
+ *
+ * @param cmd Pointer to a command buffer begun with box_rendercmd_begin_sorted.
+ * @param key Sort key, usually built with BOX_RENDERCMD_SORT_KEY.
+ */
+void box_rendercmd_set_sort_key(box_rendercmd* cmd, u64 key);
+
 /**
  * @brief Destroys and frees memory associated with the command buffer.
  *
@@ -323,6 +532,36 @@ void box_rendercmd_memory_barrier(box_rendercmd* cmd, box_renderstage* src_rende
  */
 void box_rendercmd_begin_renderstage(box_rendercmd* cmd, box_renderstage* renderstage);
 
+/**
+ * @brief Writes push constants read by the following draws or dispatches of the renderstage.
+ *
+ * The bytes are copied into the command stream, so @p data may be
+ * reused right after the call. In sorted command buffers, push constants
+ * travel with the next draw, every draw must push what it reads.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param stage Shader stage whose push constant range of the current renderstage is written.
+ * @param offset Byte offset within the push constants, a multiple of 4.
+ * @param size Number of bytes to write, a multiple of 4.
+ * @param data Bytes to write.
+ */
+void box_rendercmd_push_constants(box_rendercmd* cmd, box_shader_stage_type stage, u32 offset, u32 size, const void* data);
+
+/**
+ * @brief Writes the dynamic uniform buffer read by the following draws or dispatches of the renderstage.
+ *
+ * The bytes are copied into the command stream and, when submitted, into
+ * a ring buffer of the current frame. The binding then points at the copy,
+ * without updating any descriptor set. In sorted command buffers, uniform
+ * binds travel with the next draw like push constants.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param binding Binding of a BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor of the current renderstage.
+ * @param data Uniform data.
+ * @param size Number of bytes to write, at most box_descriptor_desc::uniform_size of the binding.
+ */
+void box_rendercmd_bind_uniform(box_rendercmd* cmd, u32 binding, const void* data, u32 size);
+
 /**
  * @brief Issues a non-indexed draw call.
  *
@@ -341,6 +580,84 @@ void box_rendercmd_draw(box_rendercmd* cmd, u32 vertex_count, u32 instance_count
  */
 void box_rendercmd_draw_indexed(box_rendercmd* cmd, u32 index_count, u32 instance_count);
 
+/**
+ * @brief Issues a non-indexed draw call of a range of the bound vertex buffer.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param vertex_count Number of vertices to draw.
+ * @param instance_count Number of instances to render.
+ * @param first_vertex Index of the first vertex to draw.
+ * @param first_instance Instance index of the first instance.
+ */
+void box_rendercmd_draw_range(box_rendercmd* cmd, u32 vertex_count, u32 instance_count, u32 first_vertex, u32 first_instance);
+
+/**
+ * @brief Issues an indexed draw call of a range of the bound index buffer.
+ *
+ * Lets many meshes share one vertex and index buffer, each drawn
+ * from its own range without binding anything in between.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param index_count Number of indices to draw.
+ * @param instance_count Number of instances to render.
+ * @param first_index Position of the first index to draw within the index buffer.
+ * @param vertex_offset Value added to every index before reading the vertex buffer.
+ * @param first_instance Instance index of the first instance.
+ */
+void box_rendercmd_draw_indexed_range(box_rendercmd* cmd, u32 index_count, u32 instance_count, u32 first_index, i32 vertex_offset, u32 first_instance);
+
+/**
+ * @brief Binds the vertex and index buffers read by the following draws of the graphics renderstage.
+ *
+ * The vertex buffer is bound to @p vertex_binding, the others keep theirs,
+ * so per-instance streams can change between draws of the same renderstage.
+ * Replaces the buffers the renderstage was created with until other
+ * buffers are bound or a renderstage is begun. In sorted command
+ * buffers, the bind travels with the next draw like push constants.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param vertex_binding Vertex binding of the renderstage @p vertex_buffer is bound to, below BOX_MAX_VERTEX_BINDINGS.
+ * @param vertex_buffer Renderbuffer created with BOX_RENDERBUFFER_USAGE_VERTEX, NULL for the one of the renderstage.
+ * @param vertex_offset Byte offset of the first vertex within @p vertex_buffer.
+ * @param index_buffer Renderbuffer created with BOX_RENDERBUFFER_USAGE_INDEX, NULL for the one of the renderstage.
+ * @param index_offset Byte offset of the first index within @p index_buffer, a multiple of the index size.
+ */
+void box_rendercmd_bind_buffers(box_rendercmd* cmd, u32 vertex_binding, box_renderbuffer* vertex_buffer, u64 vertex_offset, box_renderbuffer* index_buffer, u64 index_offset);
+
+/**
+ * @brief Issues draw calls with arguments read from a renderbuffer.
+ *
+ * Reads @p max_draw_count box_draw_indirect_args from @p buffer, or as many
+ * as the u32 at @p count_offset in @p count_buffer says if that is fewer.
+ * The arguments may be written by compute shaders of earlier renderstages.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param buffer Renderbuffer created with BOX_RENDERBUFFER_USAGE_INDIRECT.
+ * @param offset Byte offset of the first draw's arguments, a multiple of 4.
+ * @param max_draw_count Number of draws, or the upper bound when a count buffer is given.
+ * @param stride Bytes between the arguments of consecutive draws, a multiple of 4.
+ * @param count_buffer Indirect renderbuffer holding the draw count, NULL to draw @p max_draw_count times.
+ *                     Requires box_renderer_capabilities::draw_indirect_count, the command is dropped otherwise.
+ * @param count_offset Byte offset of the draw count in @p count_buffer, a multiple of 4.
+ */
+void box_rendercmd_draw_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset, u32 max_draw_count, u32 stride, box_renderbuffer* count_buffer, u64 count_offset);
+
+/**
+ * @brief Issues indexed draw calls with arguments read from a renderbuffer.
+ *
+ * Same as box_rendercmd_draw_indirect, with box_draw_indexed_indirect_args
+ * read from @p buffer.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param buffer Renderbuffer created with BOX_RENDERBUFFER_USAGE_INDIRECT.
+ * @param offset Byte offset of the first draw's arguments, a multiple of 4.
+ * @param max_draw_count Number of draws, or the upper bound when a count buffer is given.
+ * @param stride Bytes between the arguments of consecutive draws, a multiple of 4.
+ * @param count_buffer Indirect renderbuffer holding the draw count, NULL to draw @p max_draw_count times.
+ * @param count_offset Byte offset of the draw count in @p count_buffer, a multiple of 4.
+ */
+void box_rendercmd_draw_indexed_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset, u32 max_draw_count, u32 stride, box_renderbuffer* count_buffer, u64 count_offset);
+
 /**
  * @brief Dispatches a compute workload.
  *
@@ -351,6 +668,29 @@ void box_rendercmd_draw_indexed(box_rendercmd* cmd, u32 index_count, u32 instanc
  */
 void box_rendercmd_dispatch(box_rendercmd* cmd, u32 group_size_x, u32 group_size_y, u32 group_size_z);
 
+/**
+ * @brief Dispatches a compute workload with its group counts read from a renderbuffer.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param buffer Renderbuffer created with BOX_RENDERBUFFER_USAGE_INDIRECT holding box_dispatch_indirect_args.
+ * @param offset Byte offset of the arguments, a multiple of 4.
+ */
+void box_rendercmd_dispatch_indirect(box_rendercmd* cmd, box_renderbuffer* buffer, u64 offset);
+
+/**
+ * @brief Executes finished secondary command buffers inside the bound render target.
+ *
+ * Secondary command buffers are merged in the order given, regardless of
+ * which thread recorded or prepared them. A render target either executes
+ * secondary command buffers or records renderstages directly, not both.
+ * The secondary command buffers must stay alive until the command buffer is submitted.
+ *
+ * @param cmd Pointer to the command buffer.
+ * @param secondaries Secondary command buffers to execute.
+ * @param secondary_count Number of elements in @p secondaries.
+ */
+void box_rendercmd_execute_secondary(box_rendercmd* cmd, box_rendercmd** secondaries, u32 secondary_count);
+
 /**
  * @brief Ends the current render stage.
  *
@@ -23,10 +23,21 @@ b8 box_render_format_normalized(box_render_format format) {
 u32 box_render_format_channel_count(box_render_format format) {
     return (format >> 12) & 0xF;
 }
+
+u32 box_index_type_size(box_index_type type) {
+    switch (type) {
+        case BOX_INDEX_TYPE_UINT32: return 4;
+        case BOX_INDEX_TYPE_UINT8: return 1;
+        default: return 2;
+    }
+}
+
 box_renderer_backend_config box_renderer_backend_default_config() {
     box_renderer_backend_config configuration = {};
     configuration.modes = RENDERER_MODE_GRAPHICS;
 	configuration.frames_in_flight = 3;
+	configuration.recording_threads = 1;
+	configuration.uniform_ring_size = 1024 * 1024;
 
 #if BOX_ENABLE_VALIDATION
     configuration.enable_validation = TRUE;
@@ -63,6 +74,8 @@ b8 box_renderer_backend_create(box_renderer_backend* renderer_backend, box_rende
 
         renderer_backend->begin_frame     = vulkan_renderer_backend_begin_frame;
         renderer_backend->execute_command = vulkan_renderer_execute_command;
+        renderer_backend->execute_commands = vulkan_renderer_execute_commands;
+        renderer_backend->prepare_secondary = vulkan_renderer_prepare_secondary;
         renderer_backend->end_frame       = vulkan_renderer_backend_end_frame;
 
         renderer_backend->create_graphicstage            = vulkan_renderstage_create_graphic;
@@ -97,6 +110,84 @@ void box_renderer_backend_destroy(box_renderer_backend* renderer_backend) {
     bzero_memory(renderer_backend, sizeof(box_renderer_backend));
 }
 
+b8 rendercmd_context_skip_command(box_rendercmd_context* playback_context, rendercmd_header* header, rendercmd_payload* payload) {
+	box_renderstage* ended = playback_context->ended_renderstage;
+	playback_context->ended_renderstage = header->type == RENDERCMD_END_RENDERSTAGE ? playback_context->current_shader : NULL;
+
+	if (!ended || header->type != RENDERCMD_BEGIN_RENDERSTAGE || payload->begin_renderstage.renderstage != ended)
+		return FALSE;
+
+	playback_context->current_shader = ended;
+	playback_context->renderstages_skipped++;
+	return TRUE;
+}
+
+b8 playback_command(box_renderer_backend* renderer_backend, box_rendercmd_context* playback_context, rendercmd_header* hdr, rendercmd_payload* payload) {
+	if (rendercmd_context_skip_command(playback_context, hdr, payload))
+		return TRUE;
+
+	if (hdr->supported_mode)
+		playback_context->current_mode = hdr->supported_mode;
+
+	// Commands were validated when recorded, only the state read by the backend is tracked here.
+	switch (hdr->type) {
+	case RENDERCMD_BIND_RENDERTARGET:
+		playback_context->current_target = payload->bind_rendertarget.rendertarget;
+		break;
+
+	case RENDERCMD_BEGIN_RENDERSTAGE:
+		playback_context->current_shader = payload->begin_renderstage.renderstage;
+		break;
+
+	case RENDERCMD_END_RENDERSTAGE:
+		playback_context->current_shader = NULL;
+		break;
+	}
+
+	renderer_backend->execute_command(renderer_backend, playback_context, hdr, payload);
+	return TRUE;
+}
+
+// Plays back the sorted draws of one segment, beginning a renderstage only when it changes between draws.
+b8 playback_sorted_segment(box_renderer_backend* renderer_backend, box_rendercmd_context* playback_context, box_rendercmd* rendercmd, u64 first, u64 last) {
+	box_renderstage* bound = NULL;
+	rendercmd_header end_header = { RENDERCMD_END_RENDERSTAGE, 0 };
+	rendercmd_payload end_payload = {};
+
+	for (u64 i = first; i < last; ++i) {
+		box_rendercmd_sort_entry* entry = &rendercmd->sort_entries[i];
+
+		if (entry->renderstage != bound) {
+			if (bound && !playback_command(renderer_backend, playback_context, &end_header, &end_payload))
+				return FALSE;
+
+			rendercmd_header begin_header = { RENDERCMD_BEGIN_RENDERSTAGE, entry->renderstage->pipeline_type };
+			rendercmd_payload begin_payload = {};
+			begin_payload.begin_renderstage.renderstage = entry->renderstage;
+
+			if (!playback_command(renderer_backend, playback_context, &begin_header, &begin_payload))
+				return FALSE;
+
+			bound = entry->renderstage;
+		}
+
+		// Draw state recorded ahead of the draw is replayed with it, skipping anything else in between.
+		for (u64 j = entry->first_command; j < entry->command; ++j) {
+			u8* state = (u8*)freelist_get(&rendercmd->buffer, j);
+			if (!rendercmd_is_draw_state(((rendercmd_header*)state)->type)) continue;
+
+			if (!playback_command(renderer_backend, playback_context, (rendercmd_header*)state, (rendercmd_payload*)(state + sizeof(rendercmd_header))))
+				return FALSE;
+		}
+
+		u8* block = (u8*)freelist_get(&rendercmd->buffer, entry->command);
+		if (!playback_command(renderer_backend, playback_context, (rendercmd_header*)block, (rendercmd_payload*)(block + sizeof(rendercmd_header))))
+			return FALSE;
+	}
+
+	return bound ? playback_command(renderer_backend, playback_context, &end_header, &end_payload) : TRUE;
+}
+
 b8 box_renderer_backend_submit_rendercmd(box_renderer_backend* renderer_backend, box_rendercmd_context* playback_context, box_rendercmd* rendercmd) {
 	BX_ASSERT(renderer_backend != NULL && playback_context != NULL && rendercmd != NULL && "Invalid arguments passed to box_renderer_backend_submit_rendercmd");
 
@@ -107,6 +198,15 @@ b8 box_renderer_backend_submit_rendercmd(box_renderer_backend* renderer_backend,
 	}
 #endif
 
+	// Backends decoding the whole stream at once skip the call per command, sorted playback needs the front end.
+	if (!rendercmd->sorted && renderer_backend->execute_commands)
+		return renderer_backend->execute_commands(renderer_backend, playback_context, rendercmd);
+
+	// Sorted command buffers replace graphics renderstages and their draws with the sorted entries,
+	// played back whenever a fence is reached. Everything else is played back as recorded.
+	u64 entry = 0, segment = 0;
+	b8 inside_fence_stage = FALSE;
+
 	u8* cursor = 0;
 	while (freelist_next_block(&rendercmd->buffer, &cursor)) {
 		rendercmd_header* hdr = (rendercmd_header*)cursor;
@@ -114,57 +214,46 @@ b8 box_renderer_backend_submit_rendercmd(box_renderer_backend* renderer_backend,
 
 		rendercmd_payload* payload = (rendercmd_payload*)(cursor + sizeof(rendercmd_header));
 
-		if (hdr->supported_mode)
-			playback_context->current_mode = hdr->supported_mode;
+		if (rendercmd->sorted) {
+			if (rendercmd_is_sort_fence(hdr->type, hdr->supported_mode)) {
+				u64 segment_end = rendercmd->sort_segments[segment++];
+				if (!playback_sorted_segment(renderer_backend, playback_context, rendercmd, entry, segment_end))
+					return FALSE;
 
-		switch (hdr->type) {
-		case RENDERCMD_BIND_RENDERTARGET:
-#if BOX_ENABLE_VALIDATION
-			if (playback_context->current_target != NULL) {
-				BX_ERROR("Submission validation: Tried to bind rendertarget twice in box_rendercmd.");
-				return FALSE;
+				entry = segment_end;
+				inside_fence_stage = hdr->type == RENDERCMD_BEGIN_RENDERSTAGE;
 			}
-#endif
-
-			playback_context->current_target = payload->bind_rendertarget.rendertarget;
-			break;
-
-		case RENDERCMD_BEGIN_RENDERSTAGE:
-#if BOX_ENABLE_VALIDATION
-			if (playback_context->current_shader != NULL) {
-				BX_ERROR("Submission validation: Tried to begin renderstage twice in box_rendercmd.");
-				return FALSE;
+			else if (!inside_fence_stage) {
+				if (hdr->type == RENDERCMD_BEGIN_RENDERSTAGE || hdr->type == RENDERCMD_END_RENDERSTAGE ||
+					hdr->type == RENDERCMD_DRAW || hdr->type == RENDERCMD_DRAW_INDEXED ||
+					hdr->type == RENDERCMD_DRAW_INDIRECT || hdr->type == RENDERCMD_DRAW_INDEXED_INDIRECT ||
+					rendercmd_is_draw_state(hdr->type))
+					continue;
 			}
-#endif
+			else if (hdr->type == RENDERCMD_END_RENDERSTAGE) {
+				inside_fence_stage = FALSE;
+			}
+		}
 
-			playback_context->current_shader = payload->begin_renderstage.renderstage;
-			break;
+		if (!playback_command(renderer_backend, playback_context, hdr, payload))
+			return FALSE;
+	}
 
-		case RENDERCMD_END_RENDERSTAGE:
-#if BOX_ENABLE_VALIDATION
-			if (playback_context->current_shader == NULL) {
-				BX_ERROR("Submission validation: Tried to end renderstage twice in box_rendercmd.");
-				return FALSE;
-			}
-#endif
+	return TRUE;
+}
 
-			playback_context->current_shader = NULL;
-			break;
+b8 box_renderer_backend_prepare_rendercmd(box_renderer_backend* renderer_backend, box_rendercmd* rendercmd, u32 thread_index) {
+	BX_ASSERT(renderer_backend != NULL && rendercmd != NULL && "Invalid arguments passed to box_renderer_backend_prepare_rendercmd");
 
-		case RENDERCMD_DRAW:
-		case RENDERCMD_DRAW_INDEXED:
-		case RENDERCMD_DISPATCH:
 #if BOX_ENABLE_VALIDATION
-			if (playback_context->current_shader == NULL) {
-				BX_ERROR("Submission validation: Tried to dispatch draw call without a renderstage in box_rendercmd.");
-				return FALSE;
-			}
+	if (!rendercmd->finished || !rendercmd->secondary_target) {
+		BX_ERROR("box_renderer_backend_prepare_rendercmd(): Only finished secondary rendercmds can be prepared.");
+		return FALSE;
+	}
 #endif
-			break;
-		}
 
-		renderer_backend->execute_command(renderer_backend, playback_context, hdr, payload);
-	}
+	// The backend translation of static bundles is shared between frames, only the submitting thread touches it.
+	if (rendercmd->static_bundle) return TRUE;
 
-	return TRUE;
+	return renderer_backend->prepare_secondary(renderer_backend, rendercmd, thread_index);
 }
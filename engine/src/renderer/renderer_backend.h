@@ -19,6 +19,13 @@ enum {
     RENDERCMD_DRAW,
     RENDERCMD_DRAW_INDEXED,
     RENDERCMD_DISPATCH,
+    RENDERCMD_DRAW_INDIRECT,
+    RENDERCMD_DRAW_INDEXED_INDIRECT,
+    RENDERCMD_DISPATCH_INDIRECT,
+    RENDERCMD_PUSH_CONSTANTS,
+    RENDERCMD_BIND_UNIFORM,
+    RENDERCMD_BIND_BUFFERS,
+    RENDERCMD_EXECUTE_SECONDARY,
 
     /** @brief Internal command used to finalize command buffers. */
     RENDERCMD_END,
@@ -58,6 +65,9 @@ typedef union rendercmd_payload {
     struct {
         /** @brief Render target to bind for subsequent operations. */
         box_rendertarget* rendertarget;
+
+        /** @brief True if the render target is filled by secondary command buffers instead of inline commands. */
+        b8 secondary_contents;
     } bind_rendertarget;
 
     struct {
@@ -82,6 +92,12 @@ typedef union rendercmd_payload {
 
         /** @brief Number of instances to draw. */
         u32 instance_count;
+
+        /** @brief Index of the first vertex drawn. */
+        u32 first_vertex;
+
+        /** @brief Instance index of the first instance drawn. */
+        u32 first_instance;
     } draw;
 
     /**
@@ -93,8 +109,37 @@ typedef union rendercmd_payload {
 
         /** @brief Number of instances to draw. */
         u32 instance_count;
+
+        /** @brief Position of the first index drawn within the index buffer. */
+        u32 first_index;
+
+        /** @brief Value added to every index before reading the vertex buffer. */
+        i32 vertex_offset;
+
+        /** @brief Instance index of the first instance drawn. */
+        u32 first_instance;
     } draw_indexed;
 
+    /**
+     * @brief Bind buffers command payload.
+     */
+    struct {
+        /** @brief Vertex binding @ref vertex_buffer is bound to. */
+        u32 vertex_binding;
+
+        /** @brief Vertex buffer read by the following draws, NULL for the buffer of the renderstage. */
+        box_renderbuffer* vertex_buffer;
+
+        /** @brief Byte offset of the first vertex within @ref vertex_buffer. */
+        u64 vertex_offset;
+
+        /** @brief Index buffer read by the following draws, NULL for the buffer of the renderstage. */
+        box_renderbuffer* index_buffer;
+
+        /** @brief Byte offset of the first index within @ref index_buffer. */
+        u64 index_offset;
+    } bind_buffers;
+
     /**
      * @brief Compute dispatch command payload.
      */
@@ -103,10 +148,101 @@ typedef union rendercmd_payload {
         uvec3 group_size;
     } dispatch;
 
+    /**
+     * @brief Indirect draw command payload, shared by indexed and non-indexed draws.
+     */
+    struct {
+        /** @brief Buffer holding the draw arguments. */
+        box_renderbuffer* buffer;
+
+        /** @brief Byte offset of the first draw's arguments. */
+        u64 offset;
+
+        /** @brief Buffer holding the draw count, NULL to issue exactly @ref draw_count draws. */
+        box_renderbuffer* count_buffer;
+
+        /** @brief Byte offset of the draw count within @ref count_buffer. */
+        u64 count_offset;
+
+        /** @brief Number of draws, the upper bound when reading the count from @ref count_buffer. */
+        u32 draw_count;
+
+        /** @brief Bytes between the arguments of consecutive draws. */
+        u32 stride;
+    } draw_indirect;
+
+    /**
+     * @brief Indirect compute dispatch command payload.
+     */
+    struct {
+        /** @brief Buffer holding the workgroup counts. */
+        box_renderbuffer* buffer;
+
+        /** @brief Byte offset of the workgroup counts. */
+        u64 offset;
+    } dispatch_indirect;
+
+    /**
+     * @brief Push constants payload.
+     *
+     * Followed by @ref size bytes of data, see RENDERCMD_PUSH_CONSTANT_DATA.
+     */
+    struct {
+        /** @brief Byte offset within the push constants. */
+        u32 offset;
+
+        /** @brief Number of bytes written. */
+        u32 size;
+
+        /** @brief Shader stage the data was pushed for. */
+        box_shader_stage_type stage_type;
+    } push_constants;
+
+    /**
+     * @brief Bind uniform payload.
+     *
+     * Followed by @ref size bytes of data, see RENDERCMD_UNIFORM_DATA.
+     */
+    struct {
+        /** @brief Binding of the dynamic uniform buffer within the renderstage. */
+        u32 binding;
+
+        /** @brief Number of bytes of uniform data. */
+        u32 size;
+    } bind_uniform;
+
+    /**
+     * @brief Execute secondary command buffers payload.
+     *
+     * Followed by @ref rendercmd_count box_rendercmd pointers, see RENDERCMD_SECONDARY_LIST.
+     */
+    struct {
+        /** @brief Number of secondary command buffers to execute. */
+        u64 rendercmd_count;
+    } execute_secondary;
+
 } rendercmd_payload;
 
 #pragma pack(pop)
 
+/** @brief Checks if a command keeps draws from being reordered across it in sorted command buffers. */
+b8 rendercmd_is_sort_fence(rendercmd_payload_type type, box_renderer_mode mode);
+
+/** @brief Checks if a command sets state read by the next draw, which sorted command buffers move along with it. */
+b8 rendercmd_is_draw_state(rendercmd_payload_type type);
+
+/** @brief Gets the secondary command buffers stored inline after an execute_secondary payload. */
+#define RENDERCMD_SECONDARY_LIST(payload) \
+    ((box_rendercmd**)((u8*)(payload) + sizeof((payload)->execute_secondary)))
+
+/** @brief Gets the data stored inline after a push constants payload. */
+#define RENDERCMD_PUSH_CONSTANT_DATA(payload) \
+    ((const void*)((u8*)(payload) + sizeof((payload)->push_constants)))
+
+/** @brief Gets the data stored inline after a bind uniform payload. */
+#define RENDERCMD_UNIFORM_DATA(payload) \
+    ((const void*)((u8*)(payload) + sizeof((payload)->bind_uniform)))
+
 /**
  * @brief Context used during render command playback.
  *
@@ -121,8 +257,36 @@ typedef struct box_rendercmd_context {
 
     /** @brief Currently bound render stage. */
     box_renderstage* current_shader;
+
+    /** @brief Render stage ended by the previous command, beginning it again right away is skipped. */
+    box_renderstage* ended_renderstage;
+
+    /** @brief Binds issued to the backend API. */
+    u32 binds_issued;
+
+    /** @brief Binds skipped by the backend because the same state was already bound. */
+    u32 binds_skipped;
+
+    /** @brief Render stages not passed to the backend at all because they were begun again right after ending. */
+    u32 renderstages_skipped;
+
+    /** @brief Static bundles executed from their cached backend translation. */
+    u32 bundles_reused;
+
+    /** @brief Static bundles translated again, because they were new, changed, or used a changed resource. */
+    u32 bundles_recorded;
 } box_rendercmd_context;
 
+/**
+ * @brief Tracks render stage ends during playback and checks if a command can be skipped.
+ *
+ * Must be called with every command before it is executed. Ending a render stage and beginning
+ * it again right after changes nothing, so the begin is skipped and the stage stays current.
+ *
+ * @return TRUE if the command must not be passed on to the backend.
+ */
+b8 rendercmd_context_skip_command(box_rendercmd_context* playback_context, rendercmd_header* header, rendercmd_payload* payload);
+
 /**
  * @brief Renderer backend interface.
  *
@@ -185,6 +349,31 @@ typedef struct box_renderer_backend {
      */
     void (*execute_command)(struct box_renderer_backend* backend, box_rendercmd_context* playback_context, rendercmd_header* header, rendercmd_payload* payload);
 
+    /**
+     * @brief Executes every command of a finished, unsorted command buffer.
+     *
+     * Decodes the whole stream inside the backend instead of being called per command.
+     * Optional, submission falls back to execute_command when NULL.
+     *
+     * @param backend Pointer to the backend instance.
+     * @param playback_context Playback state context.
+     * @param rendercmd Command buffer to execute.
+     * @return True if execution succeeded.
+     */
+    b8 (*execute_commands)(struct box_renderer_backend* backend, box_rendercmd_context* playback_context, box_rendercmd* rendercmd);
+
+    /**
+     * @brief Translates a finished secondary command buffer into backend commands.
+     *
+     * May be called from several threads at once as long as each uses its own @p thread_index.
+     *
+     * @param backend Pointer to the backend instance.
+     * @param rendercmd Secondary command buffer to translate.
+     * @param thread_index Index of the calling recording thread.
+     * @return True if translation succeeded.
+     */
+    b8 (*prepare_secondary)(struct box_renderer_backend* backend, box_rendercmd* rendercmd, u32 thread_index);
+
     /**
      * @brief Ends the current frame.
      *
@@ -280,4 +469,21 @@ void box_renderer_backend_destroy(box_renderer_backend* renderer_backend);
  * @param rendercmd Command buffer to execute.
  * @return True if execution succeeded.
  */
-b8 box_renderer_backend_submit_rendercmd(box_renderer_backend* renderer_backend, box_rendercmd_context* playback_context, box_rendercmd* rendercmd);
\ No newline at end of file
+b8 box_renderer_backend_submit_rendercmd(box_renderer_backend* renderer_backend, box_rendercmd_context* playback_context, box_rendercmd* rendercmd);
+
+/**
+ * @brief Translates a secondary command buffer ahead of submission.
+ *
+ * Intended to be called by the thread that recorded @p rendercmd right after
+ * ending it, so translation runs in parallel across recording threads. Must be
+ * called between begin_frame and the submission of the primary command buffer
+ * that executes it. Secondary command buffers that were not prepared are
+ * translated on the submitting thread instead. Static bundles are always
+ * looked up and translated on the submitting thread, preparing them does nothing.
+ *
+ * @param renderer_backend Backend instance.
+ * @param rendercmd Finished secondary command buffer.
+ * @param thread_index Index of the calling thread, less than box_renderer_backend_config::recording_threads.
+ * @return True if translation succeeded.
+ */
+b8 box_renderer_backend_prepare_rendercmd(box_renderer_backend* renderer_backend, box_rendercmd* rendercmd, u32 thread_index);
\ No newline at end of file
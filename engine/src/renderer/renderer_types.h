@@ -162,8 +162,27 @@ typedef enum box_renderbuffer_usage {
     BOX_RENDERBUFFER_USAGE_INDEX   = 1 << 1, /**< Index buffer */
     BOX_RENDERBUFFER_USAGE_STORAGE = 1 << 2, /**< Storage buffer */
     BOX_RENDERBUFFER_USAGE_CPU_VISIBLE = 1 << 3, /**< CPU-coherent buffer */
+    BOX_RENDERBUFFER_USAGE_INDIRECT = 1 << 4, /**< Indirect draw or dispatch arguments */
+    BOX_RENDERBUFFER_USAGE_UNIFORM = 1 << 5, /**< Uniform buffer */
 } box_renderbuffer_usage;
 
+/**
+ * @brief Element type of an index buffer.
+ */
+typedef enum box_index_type {
+    BOX_INDEX_TYPE_UINT16, /**< 16-bit indices, the default */
+    BOX_INDEX_TYPE_UINT32, /**< 32-bit indices */
+    BOX_INDEX_TYPE_UINT8,  /**< 8-bit indices, only if the device supports them */
+} box_index_type;
+
+/**
+ * @brief Returns the size of a single index.
+ *
+ * @param type Index type.
+ * @return Size of an index in bytes.
+ */
+u32 box_index_type_size(box_index_type type);
+
 /**
  * @brief Intended usage of a texture.
  *
@@ -232,6 +251,7 @@ typedef enum box_descriptor_type {
     BOX_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /**< Storage buffer (SSBO) */
     BOX_DESCRIPTOR_TYPE_STORAGE_IMAGE,   /**< Storage image, no sampler */
     BOX_DESCRIPTOR_TYPE_IMAGE_SAMPLER,   /**< Combined image + sampler */
+    BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, /**< Uniform buffer (UBO) written with box_rendercmd_bind_uniform */
 } box_descriptor_type;
 
 /**
@@ -252,6 +272,17 @@ typedef enum box_shader_stage_type {
     BOX_SHADER_STAGE_TYPE_MAX,      /**< Sentinel (max stages) */
 } box_shader_stage_type;
 
+/** @brief Maximum number of vertex buffer bindings of a graphics renderstage. */
+#define BOX_MAX_VERTEX_BINDINGS 8
+
+/**
+ * @brief Rates at which a vertex binding advances.
+ */
+typedef enum box_vertex_input_rate {
+    BOX_VERTEX_INPUT_RATE_VERTEX,   /**< Advances once per vertex */
+    BOX_VERTEX_INPUT_RATE_INSTANCE, /**< Advances once per instance */
+} box_vertex_input_rate;
+
 /**
  * @brief Texture address (wrap) modes.
  */
@@ -304,8 +335,25 @@ typedef struct box_descriptor_desc {
 
     /** @brief Shader stage this descriptor is visible to. */
     box_shader_stage_type stage_type;
+
+    /** @brief Size in bytes of a dynamic uniform buffer, the most box_rendercmd_bind_uniform may write to it. */
+    u32 uniform_size;
 } box_descriptor_desc;
 
+/**
+ * @brief Describes a range of push constants visible to a shader stage.
+ */
+typedef struct box_push_constant_range {
+    /** @brief Byte offset of the range, a multiple of 4. */
+    u32 offset;
+
+    /** @brief Size of the range in bytes, a multiple of 4. */
+    u32 size;
+
+    /** @brief Shader stage the range is visible to, each stage may only have one range. */
+    box_shader_stage_type stage_type;
+} box_push_constant_range;
+
 /**
  * @brief Raw shader stage data.
  *
@@ -331,6 +379,18 @@ typedef struct box_renderer_capabilities {
 
     /** @brief Human-readable device name. */
     char* device_name;
+
+    /** @brief True if a single indirect draw command may issue more than one draw. */
+    b8 multi_draw_indirect;
+
+    /** @brief True if indirect draws may read their draw count from a buffer. */
+    b8 draw_indirect_count;
+
+    /** @brief Maximum end (offset + size) in bytes of any push constant range, at least 128. */
+    u32 max_push_constant_size;
+
+    /** @brief True if index buffers may hold BOX_INDEX_TYPE_UINT8 indices. */
+    b8 index_type_uint8;
 } box_renderer_capabilities;
 /**
  * @brief Configuration for creating a renderer backend.
@@ -358,6 +418,12 @@ typedef struct box_renderer_backend_config {
     /** @brief Enabled renderer modes (bitmask). */
     box_renderer_mode modes;
 
+    /** @brief Number of threads that may prepare secondary command buffers at the same time. */
+    u32 recording_threads;
+
+    /** @brief Bytes of uniform data a single frame may write with box_rendercmd_bind_uniform, 0 to disable it. */
+    u64 uniform_ring_size;
+
     /** @brief Selected backend API type. */
     box_renderer_backend_type api_type;
 
@@ -2,6 +2,7 @@
 #include "vulkan_backend.h"
 
 #include "platform/filesystem.h"
+#include "platform/threading.h"
 
 #include "utils/darray.h"
 #include "utils/string_utils.h"
@@ -15,8 +16,36 @@
 #include "vulkan_rendertarget.h"
 #include "vulkan_texture.h"
 #include "vulkan_image.h"
+#include "vulkan_memory.h"
 #include "vulkan_window_system.h"
 
+// Size in bytes of each per-frame transient allocator.
+#define VULKAN_FRAME_ALLOCATOR_SIZE (64 * 1024)
+
+// Number of internal objects allocated at once by each backend object pool.
+#define VULKAN_OBJECT_POOL_SLAB_SIZE 256
+
+// Upper bound on submissions and pending barriers per frame, only the pages actually used get committed.
+#define VULKAN_MAX_QUEUED_SUBMISSIONS (64 * 1024)
+#define VULKAN_MAX_MEMORY_BARRIERS (64 * 1024)
+
+// Frames recorded before the per-frame buffers are expected to have reached their steady state size.
+#define VULKAN_WARMUP_FRAMES(context) ((u64)(context)->config.frames_in_flight * 2)
+
+#if BOX_ENABLE_DIAGNOSTICS
+// Attributes the allocations the calling thread makes between the two to the frame being recorded.
+#define FRAME_PATH_BEGIN() u64 frame_path_start = memory_get_thread_allocation_count()
+#define FRAME_PATH_END(context) \
+    atomic_add_u64(&(context)->frame_path_allocations, memory_get_thread_allocation_count() - frame_path_start)
+#else
+#define FRAME_PATH_BEGIN()
+#define FRAME_PATH_END(context)
+#endif
+
+// Typed darrays for the per command hot path.
+DARRAY_DEFINE(vulkan_queue_submission)
+DARRAY_DEFINE(memory_barrier)
+
 VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
 	VkDebugUtilsMessageTypeFlagsEXT message_types,
@@ -42,12 +71,32 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
 	return VK_FALSE;
 }
 
+b8 vulkan_queue_submission_add_wait(vulkan_queue_submission* submission, VkSemaphore semaphore, u32 max_wait_semaphores) {
+	// Waiting twice on the same binary semaphore within a single submission is invalid.
+	for (u32 i = 0; i < submission->wait_semaphore_count; ++i) {
+		if (submission->wait_semaphores[i] == semaphore) 
+			return TRUE;
+	}
+
+	if (submission->wait_semaphore_count >= max_wait_semaphores) 
+		return FALSE;
+
+	// TODO: Propbably change this at some point...
+	submission->wait_stages[submission->wait_semaphore_count] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	submission->wait_semaphores[submission->wait_semaphore_count++] = semaphore;
+	return TRUE;
+}
+
 b8 vulkan_renderer_backend_initialize(box_renderer_backend* backend, box_renderer_backend_config* config) {
 	BX_ASSERT(backend != NULL && config != NULL && "Invalid arguments passed to vulkan_renderer_backend_initialize");
 	backend->internal_context = ballocate(sizeof(vulkan_context), MEMORY_TAG_RENDERER);
 	vulkan_context* context = (vulkan_context*)backend->internal_context;
 	context->config = *config;
 
+	pool_allocator_create(internal_vulkan_renderbuffer, VULKAN_OBJECT_POOL_SLAB_SIZE, MEMORY_TAG_RENDERER, &context->renderbuffer_pool);
+	pool_allocator_create(internal_vulkan_texture, VULKAN_OBJECT_POOL_SLAB_SIZE, MEMORY_TAG_RENDERER, &context->texture_pool);
+	pool_allocator_create(internal_vulkan_renderstage, VULKAN_OBJECT_POOL_SLAB_SIZE, MEMORY_TAG_RENDERER, &context->renderstage_pool);
+
 	if (backend->platform == NULL) {
 		BX_ERROR("Vulkan backend: Offscreen renderering is not supported by the Vulkan backend");
 		return FALSE;
@@ -72,7 +121,9 @@ b8 vulkan_renderer_backend_initialize(box_renderer_backend* backend, box_rendere
 	u32 supported_layer_count = 0;
 	vkEnumerateInstanceLayerProperties(&supported_layer_count, NULL);
 
-	VkLayerProperties* supported_layers = darray_reserve(VkLayerProperties, supported_layer_count, MEMORY_TAG_RENDERER);
+	DARRAY_INLINE_STORAGE(layer_storage, VkLayerProperties, 16);
+	VkLayerProperties* supported_layers = darray_create_inline(VkLayerProperties, layer_storage, MEMORY_TAG_RENDERER);
+	darray_reserve_more(supported_layers, supported_layer_count);
 	vkEnumerateInstanceLayerProperties(&supported_layer_count, supported_layers);
 	darray_length_set(supported_layers, supported_layer_count);
 
@@ -262,6 +313,48 @@ b8 vulkan_renderer_backend_initialize(box_renderer_backend* backend, box_rendere
 		}
 	}
 
+	if (config->modes & RENDERER_MODE_GRAPHICS) {
+		context->recording_thread_count = BX_MAX(config->recording_threads, 1);
+		context->recording_threads = darray_reserve(vulkan_recording_thread, config->frames_in_flight * context->recording_thread_count, MEMORY_TAG_RENDERER);
+
+		for (u32 i = 0; i < config->frames_in_flight * context->recording_thread_count; ++i) {
+			vulkan_recording_thread* thread = darray_push_empty(context->recording_threads);
+			thread->queue = context->device.mode_queues[VULKAN_QUEUE_TYPE_GRAPHICS];
+			thread->queue.pool = VK_NULL_HANDLE;
+			thread->command_buffers = darray_create(vulkan_secondary_command_buffer*, MEMORY_TAG_RENDERER);
+
+			// Reset as a whole at the start of the frame, so single buffers never need resetting.
+			VkCommandPoolCreateInfo pool_create_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			pool_create_info.queueFamilyIndex = thread->queue.family_index;
+			pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			CHECK_VKRESULT(
+				vkCreateCommandPool(
+					context->device.logical_device,
+					&pool_create_info,
+					context->allocator,
+					&thread->queue.pool),
+				"Failed to create Vulkan recording thread command pool");
+		}
+
+		// Static bundles outlive frames and are re-recorded one command buffer at a time.
+		context->static_bundles = darray_create(vulkan_static_bundle*, MEMORY_TAG_RENDERER);
+		context->static_bundle_queue = context->device.mode_queues[VULKAN_QUEUE_TYPE_GRAPHICS];
+		context->static_bundle_queue.pool = VK_NULL_HANDLE;
+
+		VkCommandPoolCreateInfo pool_create_info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+		pool_create_info.queueFamilyIndex = context->static_bundle_queue.family_index;
+		pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		CHECK_VKRESULT(
+			vkCreateCommandPool(
+				context->device.logical_device,
+				&pool_create_info,
+				context->allocator,
+				&context->static_bundle_queue.pool),
+			"Failed to create Vulkan static bundle command pool");
+	}
+
 	if (config->modes & RENDERER_MODE_COMPUTE) {
 		vulkan_queue_type queue_type = VULKAN_QUEUE_TYPE_COMPUTE;
 		context->compute_command_ring = darray_reserve(vulkan_command_buffer, config->frames_in_flight, MEMORY_TAG_RENDERER);
@@ -280,8 +373,13 @@ b8 vulkan_renderer_backend_initialize(box_renderer_backend* backend, box_rendere
 
     // Per frame structures (needs BIG improvements soon)
     // --------------------------------------
-	context->memory_barriers = darray_create(memory_barrier, MEMORY_TAG_RENDERER);
-	context->queued_submissions = darray_create(vulkan_queue_submission, MEMORY_TAG_RENDERER);
+	context->memory_barriers = darray_create_virtual(memory_barrier, VULKAN_MAX_MEMORY_BARRIERS, MEMORY_TAG_RENDERER);
+	context->queued_submissions = darray_create_virtual(vulkan_queue_submission, VULKAN_MAX_QUEUED_SUBMISSIONS, MEMORY_TAG_RENDERER);
+	if (!context->memory_barriers || !context->queued_submissions) {
+		BX_ERROR("Failed to reserve per frame submission arrays");
+		return FALSE;
+	}
+
 	context->semaphore_pool = darray_create(VkSemaphore, MEMORY_TAG_RENDERER);
 
 	VkSemaphoreCreateInfo semaphore_create_info = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
@@ -296,6 +394,21 @@ b8 vulkan_renderer_backend_initialize(box_renderer_backend* backend, box_rendere
 				semaphore),
 			"Failed to create Vulkan semaphore in pool");
 	}
+
+	context->frame_allocators = darray_reserve(frame_allocator, config->frames_in_flight, MEMORY_TAG_RENDERER);
+	for (u32 i = 0; i < config->frames_in_flight; ++i) {
+		frame_allocator* allocator = darray_push_empty(context->frame_allocators);
+
+		if (!frame_allocator_create(VULKAN_FRAME_ALLOCATOR_SIZE, MEMORY_TAG_RENDERER, allocator)) {
+			BX_ERROR("Failed to create Vulkan frame allocator");
+			return FALSE;
+		}
+	}
+
+	if (config->uniform_ring_size > 0 && !vulkan_uniform_ring_create(backend, config->uniform_ring_size)) {
+		BX_ERROR("Failed to create Vulkan uniform ring");
+		return FALSE;
+	}
     // --------------------------------------
 	return TRUE;
 }
@@ -322,6 +435,15 @@ void vulkan_renderer_backend_shutdown(box_renderer_backend* backend) {
 		darray_destroy(context->semaphore_pool);
 	}
 
+	if (context->frame_allocators) {
+		for (u32 i = 0; i < darray_length(context->frame_allocators); ++i)
+			frame_allocator_destroy(&context->frame_allocators[i]);
+
+		darray_destroy(context->frame_allocators);
+	}
+
+	vulkan_uniform_ring_destroy(backend);
+
 	if (context->memory_barriers) darray_destroy(context->memory_barriers);
 
 	if (context->queued_submissions) darray_destroy(context->queued_submissions);
@@ -347,6 +469,47 @@ void vulkan_renderer_backend_shutdown(box_renderer_backend* backend) {
 		darray_destroy(context->compute_command_ring);
 	}
 
+	if (context->recording_threads) {
+		for (u32 i = 0; i < darray_length(context->recording_threads); ++i) {
+			vulkan_recording_thread* thread = &context->recording_threads[i];
+
+			// Command buffers are freed together with their pool.
+			for (u32 j = 0; j < darray_length(thread->command_buffers); ++j) {
+				darray_destroy(thread->command_buffers[j]->renderstages);
+				bfree(thread->command_buffers[j], sizeof(vulkan_secondary_command_buffer), MEMORY_TAG_RENDERER);
+			}
+
+			darray_destroy(thread->command_buffers);
+
+			if (thread->queue.pool)
+				vkDestroyCommandPool(context->device.logical_device, thread->queue.pool, context->allocator);
+		}
+
+		darray_destroy(context->recording_threads);
+	}
+
+	if (context->static_bundles) {
+		// Command buffers are freed together with their pool.
+		for (u32 i = 0; i < darray_length(context->static_bundles); ++i) {
+			vulkan_static_bundle* bundle = context->static_bundles[i];
+
+			for (u32 j = 0; j < darray_length(bundle->frames); ++j) {
+				darray_destroy(bundle->frames[j].secondary.renderstages);
+				darray_destroy(bundle->frames[j].renderstage_generations);
+				darray_destroy(bundle->frames[j].renderbuffers);
+				darray_destroy(bundle->frames[j].renderbuffer_generations);
+			}
+
+			darray_destroy(bundle->frames);
+			bfree(bundle, sizeof(vulkan_static_bundle), MEMORY_TAG_RENDERER);
+		}
+
+		darray_destroy(context->static_bundles);
+	}
+
+	if (context->static_bundle_queue.pool)
+		vkDestroyCommandPool(context->device.logical_device, context->static_bundle_queue.pool, context->allocator);
+
 	if (context->in_flight_fences) {
 		for (u32 i = 0; i < darray_length(context->in_flight_fences); ++i) {
 			if (!context->in_flight_fences[i]) continue;
@@ -367,6 +530,7 @@ void vulkan_renderer_backend_shutdown(box_renderer_backend* backend) {
 		vulkan_window_system_destroy(backend, window_system);
 	}
 
+	vulkan_memory_shutdown(context);
 	vulkan_device_destroy(backend);
 
 	if (context->instance) {
@@ -380,6 +544,10 @@ void vulkan_renderer_backend_shutdown(box_renderer_backend* backend) {
 		vkDestroyInstance(context->instance, context->allocator);
 	}
 
+	pool_allocator_destroy(&context->renderstage_pool);
+	pool_allocator_destroy(&context->texture_pool);
+	pool_allocator_destroy(&context->renderbuffer_pool);
+
 	bfree(context, sizeof(vulkan_context), MEMORY_TAG_RENDERER);
 	backend->internal_context = NULL;
 }
@@ -392,6 +560,7 @@ void vulkan_renderer_backend_on_resized(box_renderer_backend* backend, uvec2 new
 b8 vulkan_renderer_backend_begin_frame(box_renderer_backend* backend, f64 delta_time) {
 	BX_ASSERT(backend != NULL && "Invalid arguments passed to vulkan_renderer_backend_begin_frame");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
+	FRAME_PATH_BEGIN();
 
 	CHECK_VKRESULT(
 		vkWaitForFences(
@@ -407,6 +576,10 @@ b8 vulkan_renderer_backend_begin_frame(box_renderer_backend* backend, f64 delta_
 			1, &context->in_flight_fences[context->current_frame]),
 		"Failed to wait or reset Vulkan fence");
 
+	// Everything allocated the last time this frame was recorded is no longer in use by the GPU.
+	frame_allocator_reset(&context->frame_allocators[context->current_frame]);
+	atomic_store_u64(&context->uniform_ring.head, 0);
+
 	if (backend->platform != NULL) {
 		vulkan_window_system* window_system = (vulkan_window_system*)backend->platform->internal_renderer_state;
 
@@ -419,57 +592,400 @@ b8 vulkan_renderer_backend_begin_frame(box_renderer_backend* backend, f64 delta_
 			"Failed to accquire next Vulkan swapchain image");
 	}
 	
+	// Secondary command buffers recorded the last time this frame came around are done as well.
+	for (u32 i = 0; i < context->recording_thread_count; ++i) {
+		vulkan_recording_thread* thread = &context->recording_threads[context->current_frame * context->recording_thread_count + i];
+		if (thread->used_count == 0) continue;
+
+		CHECK_VKRESULT(
+			vkResetCommandPool(context->device.logical_device, thread->queue.pool, 0),
+			"Failed to reset Vulkan recording thread command pool");
+		thread->used_count = 0;
+	}
+
 	darray_length_set(context->memory_barriers, 0);
 	darray_length_set(context->queued_submissions, 0);
 	context->last_mode = 0;
+
+	FRAME_PATH_END(context);
     return TRUE;
 }
 
-void vulkan_renderer_execute_command(box_renderer_backend* backend, box_rendercmd_context* rendercmd_context, rendercmd_header* header, rendercmd_payload* payload) {
-	BX_ASSERT(backend != NULL && rendercmd_context != NULL && header != NULL && payload != NULL && "Invalid arguments passed to vulkan_renderer_execute_command");
+// Makes the submission wait on every pending memory barrier targeting the renderstage.
+void vulkan_renderer_wait_barriers(vulkan_context* context, vulkan_queue_submission* submission, box_renderstage* renderstage) {
+	for (u32 i = 0; i < darray_length(context->memory_barriers); ++i) {
+		if (context->memory_barriers[i].dst_renderstage != renderstage)
+			continue;
+		
+		// Barriers are unordered, swap removal keeps the loop O(n).
+		memory_barrier barrier = {};
+		darray_swap_remove(context->memory_barriers, i, &barrier);
+
+		vulkan_queue_submission_add_wait(
+			submission,
+			context->queued_submissions[barrier.created_on_submission].signal_semaphore,
+			darray_length(context->semaphore_pool) + 1);
+		--i;
+	}
+}
+
+// Records indirect draws, splitting them into single draws when the device can not issue several at once.
+void vulkan_renderer_record_draw_indirect(vulkan_context* context, vulkan_command_buffer* command_buffer, b8 indexed, rendercmd_payload* payload) {
+    VkBuffer buffer = ((internal_vulkan_renderbuffer*)payload->draw_indirect.buffer->internal_data)->handle;
+
+    if (payload->draw_indirect.count_buffer) {
+        // Count buffer draws are rejected when recorded on devices without support.
+        BX_ASSERT(context->device.draw_indirect_count && "Indirect count draw recorded on a device without support");
+
+        VkBuffer count_buffer = ((internal_vulkan_renderbuffer*)payload->draw_indirect.count_buffer->internal_data)->handle;
+        if (indexed)
+            vkCmdDrawIndexedIndirectCount(command_buffer->handle,
+                                          buffer, payload->draw_indirect.offset,
+                                          count_buffer, payload->draw_indirect.count_offset,
+                                          payload->draw_indirect.draw_count, payload->draw_indirect.stride);
+        else
+            vkCmdDrawIndirectCount(command_buffer->handle,
+                                   buffer, payload->draw_indirect.offset,
+                                   count_buffer, payload->draw_indirect.count_offset,
+                                   payload->draw_indirect.draw_count, payload->draw_indirect.stride);
+        return;
+    }
+
+    u32 batch_size = context->device.multi_draw_indirect ? payload->draw_indirect.draw_count : 1;
+    for (u32 drawn = 0; drawn < payload->draw_indirect.draw_count; drawn += batch_size) {
+        VkDeviceSize offset = payload->draw_indirect.offset + (VkDeviceSize)drawn * payload->draw_indirect.stride;
+        if (indexed)
+            vkCmdDrawIndexedIndirect(command_buffer->handle, buffer, offset, batch_size, payload->draw_indirect.stride);
+        else
+            vkCmdDrawIndirect(command_buffer->handle, buffer, offset, batch_size, payload->draw_indirect.stride);
+    }
+}
+
+// Records draw commands, shared by primary and secondary command buffers.
+void vulkan_renderer_record_draw(vulkan_context* context, vulkan_command_buffer* command_buffer, rendercmd_header* header, rendercmd_payload* payload) {
+    switch (header->type) {
+    case RENDERCMD_DRAW:
+        vkCmdDraw(command_buffer->handle,
+                  payload->draw.vertex_count,
+                  payload->draw.instance_count,
+                  payload->draw.first_vertex,
+                  payload->draw.first_instance);
+        break;
+
+    case RENDERCMD_DRAW_INDEXED:
+        vkCmdDrawIndexed(command_buffer->handle,
+                         payload->draw_indexed.index_count,
+                         payload->draw_indexed.instance_count,
+                         payload->draw_indexed.first_index,
+                         payload->draw_indexed.vertex_offset,
+                         payload->draw_indexed.first_instance);
+        break;
+
+    case RENDERCMD_DRAW_INDIRECT:
+    case RENDERCMD_DRAW_INDEXED_INDIRECT:
+        vulkan_renderer_record_draw_indirect(context, command_buffer, header->type == RENDERCMD_DRAW_INDEXED_INDIRECT, payload);
+        break;
+    }
+}
+
+// Translates a secondary box_rendercmd into 'secondary', remembering every renderstage it begins.
+b8 vulkan_renderer_record_secondary(vulkan_context* context, vulkan_secondary_command_buffer* secondary, box_rendercmd* rendercmd, VkFramebuffer framebuffer, b8 is_single_use) {
+	secondary->source = rendercmd;
+	secondary->frame_number = context->frame_number;
+	darray_clear(secondary->renderstages);
+
+	box_rendertarget* rendertarget = rendercmd->secondary_target;
+	internal_vulkan_rendertarget* internal_rendertarget = (internal_vulkan_rendertarget*)rendertarget->internal_data;
+
+	CHECK_VKRESULT(
+		vulkan_command_buffer_begin_secondary(
+			&secondary->command_buffer,
+			internal_rendertarget->handle,
+			framebuffer,
+			is_single_use),
+		"Failed to begin Vulkan secondary command buffer");
+
+	// Dynamic state is not inherited from the primary command buffer.
+	vulkan_rendertarget_set_area(context, &secondary->command_buffer, rendertarget, TRUE, TRUE);
+
+	box_renderstage* renderstage = NULL;
+
+	u8* cursor = 0;
+	while (freelist_next_block(&rendercmd->buffer, &cursor)) {
+		rendercmd_header* header = (rendercmd_header*)cursor;
+		rendercmd_payload* payload = (rendercmd_payload*)(cursor + sizeof(rendercmd_header));
+
+		switch (header->type) {
+		case RENDERCMD_BEGIN_RENDERSTAGE:
+			renderstage = payload->begin_renderstage.renderstage;
+			darray_push(secondary->renderstages, renderstage);
+			vulkan_renderstage_bind(context, &secondary->command_buffer, renderstage, NULL);
+			break;
+
+		case RENDERCMD_PUSH_CONSTANTS:
+			vulkan_renderstage_push_constants(&secondary->command_buffer, renderstage, payload);
+			break;
+
+		case RENDERCMD_BIND_UNIFORM:
+			vulkan_renderstage_bind_uniform(context, &secondary->command_buffer, renderstage, payload);
+			break;
+
+		case RENDERCMD_BIND_BUFFERS:
+			vulkan_renderstage_bind_buffers(&secondary->command_buffer, renderstage, payload, NULL);
+			break;
+
+		case RENDERCMD_DRAW:
+		case RENDERCMD_DRAW_INDEXED:
+		case RENDERCMD_DRAW_INDIRECT:
+		case RENDERCMD_DRAW_INDEXED_INDIRECT:
+			vulkan_renderer_record_draw(context, &secondary->command_buffer, header, payload);
+			break;
+		}
+	}
+
+	CHECK_VKRESULT(
+		vulkan_command_buffer_end(&secondary->command_buffer),
+		"Failed to end Vulkan secondary command buffer");
+	return TRUE;
+}
+
+b8 vulkan_renderer_prepare_secondary(box_renderer_backend* backend, box_rendercmd* rendercmd, u32 thread_index) {
+	BX_ASSERT(backend != NULL && rendercmd != NULL && rendercmd->secondary_target != NULL && "Invalid arguments passed to vulkan_renderer_prepare_secondary");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
+	FRAME_PATH_BEGIN();
 
-	if (rendercmd_context->current_mode != context->last_mode) {
-		// Create new queue submission
-		vulkan_queue_submission* new = darray_push_empty(context->queued_submissions);
+#if BOX_ENABLE_VALIDATION
+	if (thread_index >= context->recording_thread_count) {
+		BX_ERROR("vulkan_renderer_prepare_secondary(): Thread index %u is out of range, backend was created with %u recording thread(s).", thread_index, context->recording_thread_count);
+		return FALSE;
+	}
+#endif
 
-		switch (rendercmd_context->current_mode) {
-			case RENDERER_MODE_GRAPHICS: 
-				new->command_buffer = &context->graphics_command_ring[context->current_frame];
-				break;
+	vulkan_recording_thread* thread = &context->recording_threads[context->current_frame * context->recording_thread_count + thread_index];
+	if (thread->used_count == darray_length(thread->command_buffers)) {
+		vulkan_secondary_command_buffer* new = ballocate(sizeof(vulkan_secondary_command_buffer), MEMORY_TAG_RENDERER);
+		new->renderstages = darray_create(box_renderstage*, MEMORY_TAG_RENDERER);
+		darray_push(thread->command_buffers, new);
 
-			case RENDERER_MODE_COMPUTE: 
-				new->command_buffer = &context->compute_command_ring[context->current_frame];
-				break;
+		CHECK_VKRESULT(
+			vulkan_command_buffer_allocate(context, &thread->queue, FALSE, &new->command_buffer),
+			"Failed to allocate Vulkan secondary command buffer");
+	}
 
-			default:
-				BX_ASSERT(FALSE && "Unsupported renderer mode");
-				break;
+	vulkan_secondary_command_buffer* secondary = thread->command_buffers[thread->used_count++];
+	internal_vulkan_rendertarget* internal_rendertarget = (internal_vulkan_rendertarget*)rendercmd->secondary_target->internal_data;
+
+	if (!vulkan_renderer_record_secondary(context, secondary, rendercmd, internal_rendertarget->framebuffers[context->image_index], TRUE))
+		return FALSE;
+
+	rendercmd->internal_data = secondary;
+
+	FRAME_PATH_END(context);
+	return TRUE;
+}
+
+// Finds the static bundle translated for the rendercmd, or hands out one no frame in flight uses anymore.
+vulkan_static_bundle* vulkan_renderer_acquire_static_bundle(vulkan_context* context, box_rendercmd* rendercmd) {
+	vulkan_static_bundle* bundle = (vulkan_static_bundle*)rendercmd->internal_data;
+	if (bundle && bundle->source == rendercmd) return bundle;
+
+	bundle = NULL;
+	for (u32 i = 0; i < darray_length(context->static_bundles); ++i) {
+		vulkan_static_bundle* candidate = context->static_bundles[i];
+		if (candidate->source == rendercmd) return candidate;
+
+		if (!bundle && candidate->last_used_frame + context->config.frames_in_flight <= context->frame_number)
+			bundle = candidate;
+	}
+
+	if (!bundle) {
+		bundle = ballocate(sizeof(vulkan_static_bundle), MEMORY_TAG_RENDERER);
+		bundle->frames = darray_reserve(vulkan_static_bundle_frame, context->config.frames_in_flight, MEMORY_TAG_RENDERER);
+
+		for (u32 i = 0; i < context->config.frames_in_flight; ++i) {
+			vulkan_static_bundle_frame* frame = darray_push_empty(bundle->frames);
+			bzero_memory(frame, sizeof(vulkan_static_bundle_frame));
+			frame->secondary.renderstages = darray_create(box_renderstage*, MEMORY_TAG_RENDERER);
+			frame->renderstage_generations = darray_create(u64, MEMORY_TAG_RENDERER);
+			frame->renderbuffers = darray_create(box_renderbuffer*, MEMORY_TAG_RENDERER);
+			frame->renderbuffer_generations = darray_create(u64, MEMORY_TAG_RENDERER);
+
+			if (!vulkan_result_is_success(vulkan_command_buffer_allocate(context, &context->static_bundle_queue, FALSE, &frame->secondary.command_buffer))) {
+				BX_ERROR("Failed to allocate Vulkan static bundle command buffer");
+				frame->secondary.command_buffer.handle = VK_NULL_HANDLE;
+			}
 		}
 
-		new->signal_semaphore = context->semaphore_pool[context->semaphore_next_index];
-		context->semaphore_next_index = (context->semaphore_next_index + 1) % darray_length(context->semaphore_pool);
+		darray_push(context->static_bundles, bundle);
+	}
+
+	for (u32 i = 0; i < darray_length(bundle->frames); ++i)
+		bundle->frames[i].recorded = FALSE;
 
-		new->wait_semaphores = darray_create(VkSemaphore, MEMORY_TAG_RENDERER);
+	bundle->source = rendercmd;
+	return bundle;
+}
+
+// Checks whether a translation still matches the commands and resources of the rendercmd.
+b8 vulkan_static_bundle_frame_valid(vulkan_static_bundle_frame* frame, box_rendercmd* rendercmd) {
+	if (!frame->recorded || frame->binds_uniforms || frame->content_hash != rendercmd->content_hash) return FALSE;
+
+	box_rendertarget* rendertarget = rendercmd->secondary_target;
+	if (frame->rendertarget_generation != ((internal_vulkan_rendertarget*)rendertarget->internal_data)->generation ||
+		frame->origin.x != rendertarget->origin.x || frame->origin.y != rendertarget->origin.y ||
+		frame->size.width != rendertarget->size.width || frame->size.height != rendertarget->size.height)
+		return FALSE;
 
-        vulkan_command_buffer_reset(new->command_buffer);
-		vulkan_command_buffer_begin(new->command_buffer, FALSE, FALSE, FALSE);
+	for (u32 i = 0; i < darray_length(frame->secondary.renderstages); ++i) {
+		if (frame->renderstage_generations[i] != vulkan_renderstage_generation(frame->secondary.renderstages[i]))
+			return FALSE;
 	}
 
-	context->last_mode = rendercmd_context->current_mode;
-	
-	vulkan_queue_submission* curr_submission = &context->queued_submissions[darray_length(context->queued_submissions) - 1];
+	for (u32 i = 0; i < darray_length(frame->renderbuffers); ++i) {
+		if (frame->renderbuffer_generations[i] != ((internal_vulkan_renderbuffer*)frame->renderbuffers[i]->internal_data)->generation)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Remembers a renderbuffer baked into a static bundle translation along with its generation.
+void vulkan_static_bundle_frame_track(vulkan_static_bundle_frame* frame, box_renderbuffer* renderbuffer) {
+	if (!renderbuffer) return;
+
+	darray_push(frame->renderbuffers, renderbuffer);
+	darray_push(frame->renderbuffer_generations, ((internal_vulkan_renderbuffer*)renderbuffer->internal_data)->generation);
+}
 
+// Gets the translation of a static bundle for the current frame, only recording it again when it went stale.
+vulkan_secondary_command_buffer* vulkan_renderer_prepare_static(vulkan_context* context, box_rendercmd_context* rendercmd_context, box_rendercmd* rendercmd) {
+	vulkan_static_bundle* bundle = vulkan_renderer_acquire_static_bundle(context, rendercmd);
+	vulkan_static_bundle_frame* frame = &bundle->frames[context->current_frame];
+
+#if BOX_ENABLE_VALIDATION
+	// Without simultaneous use, the command buffer must not be executed again while the frame is pending.
+	if (frame->recorded && frame->secondary.frame_number == context->frame_number) {
+		BX_ERROR("vulkan_renderer_prepare_static(): Tried to execute a static bundle more than once in a frame.");
+		return NULL;
+	}
+#endif
+
+	rendercmd->internal_data = bundle;
+	bundle->last_used_frame = context->frame_number;
+
+	if (vulkan_static_bundle_frame_valid(frame, rendercmd)) {
+		frame->secondary.frame_number = context->frame_number;
+		rendercmd_context->bundles_reused++;
+		return &frame->secondary;
+	}
+
+	if (!frame->secondary.command_buffer.handle) return NULL;
+
+	// The framebuffer changes with the swapchain image, so the translation must not depend on it.
+	frame->recorded = FALSE;
+	if (!vulkan_renderer_record_secondary(context, &frame->secondary, rendercmd, VK_NULL_HANDLE, FALSE))
+		return NULL;
+
+	box_rendertarget* rendertarget = rendercmd->secondary_target;
+	frame->recorded = TRUE;
+	frame->content_hash = rendercmd->content_hash;
+	frame->rendertarget_generation = ((internal_vulkan_rendertarget*)rendertarget->internal_data)->generation;
+	frame->origin = rendertarget->origin;
+	frame->size = rendertarget->size;
+
+	darray_clear(frame->renderstage_generations);
+	for (u32 i = 0; i < darray_length(frame->secondary.renderstages); ++i)
+		darray_push(frame->renderstage_generations, vulkan_renderstage_generation(frame->secondary.renderstages[i]));
+
+	// Indirect draws and buffer binds bake their buffers into the translation as well.
+	darray_clear(frame->renderbuffers);
+	darray_clear(frame->renderbuffer_generations);
+	frame->binds_uniforms = FALSE;
+
+	u8* cursor = 0;
+	while (freelist_next_block(&rendercmd->buffer, &cursor)) {
+		rendercmd_header* header = (rendercmd_header*)cursor;
+		rendercmd_payload* payload = (rendercmd_payload*)(cursor + sizeof(rendercmd_header));
+
+		if (header->type == RENDERCMD_DRAW_INDIRECT || header->type == RENDERCMD_DRAW_INDEXED_INDIRECT) {
+			vulkan_static_bundle_frame_track(frame, payload->draw_indirect.buffer);
+			vulkan_static_bundle_frame_track(frame, payload->draw_indirect.count_buffer);
+		}
+
+		if (header->type == RENDERCMD_BIND_BUFFERS) {
+			vulkan_static_bundle_frame_track(frame, payload->bind_buffers.vertex_buffer);
+			vulkan_static_bundle_frame_track(frame, payload->bind_buffers.index_buffer);
+		}
+
+		// Uniform data is copied into the ring of the frame, so the translation has to be recorded every frame.
+		if (header->type == RENDERCMD_BIND_UNIFORM)
+			frame->binds_uniforms = TRUE;
+	}
+
+	rendercmd_context->bundles_recorded++;
+	return &frame->secondary;
+}
+
+// Starts a new queue submission recording commands of the given mode, returns NULL once the frame has no submissions left.
+vulkan_queue_submission* vulkan_renderer_begin_submission(vulkan_context* context, box_renderer_mode mode) {
+	vulkan_queue_submission* new = darray_vulkan_queue_submission_push_empty(&context->queued_submissions);
+	if (!new) {
+		BX_ERROR("Exceeded %u queue submissions in a frame, dropping render commands", VULKAN_MAX_QUEUED_SUBMISSIONS);
+		return NULL;
+	}
+
+	switch (mode) {
+		case RENDERER_MODE_GRAPHICS: 
+			new->command_buffer = &context->graphics_command_ring[context->current_frame];
+			break;
+
+		case RENDERER_MODE_COMPUTE: 
+			new->command_buffer = &context->compute_command_ring[context->current_frame];
+			break;
+
+		default:
+			BX_ASSERT(FALSE && "Unsupported renderer mode");
+			break;
+	}
+
+	new->signal_semaphore = context->semaphore_pool[context->semaphore_next_index];
+	context->semaphore_next_index = (context->semaphore_next_index + 1) % darray_length(context->semaphore_pool);
+
+	// A submission can wait at most on every semaphore in the pool plus the image acquisition semaphore.
+	frame_allocator* allocator = &context->frame_allocators[context->current_frame];
+	u32 max_wait_semaphores = darray_length(context->semaphore_pool) + 1;
+
+	new->wait_semaphores = frame_allocator_allocate(allocator, sizeof(VkSemaphore) * max_wait_semaphores);
+	new->wait_stages = frame_allocator_allocate(allocator, sizeof(VkPipelineStageFlags) * max_wait_semaphores);
+	new->wait_semaphore_count = 0;
+	BX_ASSERT(new->wait_semaphores != NULL && new->wait_stages != NULL && "Vulkan frame allocator exhausted");
+
+    vulkan_command_buffer_reset(new->command_buffer);
+	vulkan_command_buffer_begin(new->command_buffer, FALSE, FALSE, FALSE);
+
+	context->last_mode = mode;
+	return new;
+}
+
+// Records a single command into the submission, keeping the targets of the playback context current.
+void vulkan_renderer_record_command(box_renderer_backend* backend, vulkan_context* context, box_rendercmd_context* rendercmd_context, vulkan_queue_submission* submission, rendercmd_header* header, rendercmd_payload* payload) {
     switch (header->type) {
     case RENDERCMD_BIND_RENDERTARGET:
+		rendercmd_context->current_target = payload->bind_rendertarget.rendertarget;
         vulkan_rendertarget_begin(
-			context, curr_submission->command_buffer,
+			context, submission->command_buffer,
             rendercmd_context->current_target,
-            TRUE, TRUE);
+            TRUE, TRUE,
+			payload->bind_rendertarget.secondary_contents);
         break;
 
 	case RENDERCMD_MEMORY_BARRIER:
-		memory_barrier* barrier = darray_push_empty(context->memory_barriers);
+		memory_barrier* barrier = darray_memory_barrier_push_empty(&context->memory_barriers);
+		if (!barrier) {
+			BX_ERROR("Exceeded %u pending memory barriers in a frame, dropping the barrier", VULKAN_MAX_MEMORY_BARRIERS);
+			break;
+		}
+
 		barrier->created_on_submission = darray_length(context->queued_submissions) - 1;
 		barrier->src_renderstage = payload->memory_barrier.src_renderstage;
 		barrier->dst_renderstage = payload->memory_barrier.dst_renderstage;
@@ -478,62 +994,153 @@ void vulkan_renderer_execute_command(box_renderer_backend* backend, box_rendercm
 		break;
 
     case RENDERCMD_BEGIN_RENDERSTAGE:
-		for (u32 i = 0; i < darray_length(context->memory_barriers); ++i) {
-			if (context->memory_barriers[i].dst_renderstage != payload->begin_renderstage.renderstage)
-				continue;
-			
-			memory_barrier barrier = {};
-			darray_pop_at(context->memory_barriers, i, &barrier);
-
-			darray_push(curr_submission->wait_semaphores, 
-						context->queued_submissions[barrier.created_on_submission].signal_semaphore);
-			--i;
-		}
+		rendercmd_context->current_shader = payload->begin_renderstage.renderstage;
+		vulkan_renderer_wait_barriers(context, submission, payload->begin_renderstage.renderstage);
 
         vulkan_renderstage_bind(
-            context, curr_submission->command_buffer,
-            rendercmd_context->current_shader);
+            context, submission->command_buffer,
+            rendercmd_context->current_shader,
+            rendercmd_context);
         break;
 
-    case RENDERCMD_DRAW:
-        vkCmdDraw(curr_submission->command_buffer->handle,
-                  payload->draw.vertex_count,
-                  payload->draw.instance_count,
-                  0, 0);
-        break;
+    case RENDERCMD_END_RENDERSTAGE:
+		rendercmd_context->current_shader = NULL;
+		break;
+
+	case RENDERCMD_PUSH_CONSTANTS:
+		vulkan_renderstage_push_constants(submission->command_buffer, rendercmd_context->current_shader, payload);
+		break;
+
+	case RENDERCMD_BIND_UNIFORM:
+		vulkan_renderstage_bind_uniform(context, submission->command_buffer, rendercmd_context->current_shader, payload);
+		break;
+
+	case RENDERCMD_BIND_BUFFERS:
+		vulkan_renderstage_bind_buffers(submission->command_buffer, rendercmd_context->current_shader, payload, rendercmd_context);
+		break;
 
+    case RENDERCMD_DRAW:
     case RENDERCMD_DRAW_INDEXED:
-        vkCmdDrawIndexed(curr_submission->command_buffer->handle,
-                         payload->draw_indexed.index_count,
-                         payload->draw_indexed.instance_count,
-                         0, 0, 0);
+    case RENDERCMD_DRAW_INDIRECT:
+    case RENDERCMD_DRAW_INDEXED_INDIRECT:
+		vulkan_renderer_record_draw(context, submission->command_buffer, header, payload);
         break;
 
+	case RENDERCMD_EXECUTE_SECONDARY:
+		u64 secondary_count = payload->execute_secondary.rendercmd_count;
+		box_rendercmd** secondaries = RENDERCMD_SECONDARY_LIST(payload);
+
+		VkCommandBuffer* handles = frame_allocator_allocate(&context->frame_allocators[context->current_frame], sizeof(VkCommandBuffer) * secondary_count);
+		BX_ASSERT((handles != NULL || secondary_count == 0) && "Vulkan frame allocator exhausted");
+
+		u32 handle_count = 0;
+		for (u64 i = 0; i < secondary_count; ++i) {
+			vulkan_secondary_command_buffer* secondary = (vulkan_secondary_command_buffer*)secondaries[i]->internal_data;
+
+			if (secondaries[i]->static_bundle) {
+				secondary = vulkan_renderer_prepare_static(context, rendercmd_context, secondaries[i]);
+				if (!secondary) continue;
+			}
+			// Secondaries nobody prepared this frame are translated here, recording threads are done by submission.
+			else if (!secondary || secondary->source != secondaries[i] || secondary->frame_number != context->frame_number) {
+				if (!vulkan_renderer_prepare_secondary(backend, secondaries[i], 0)) continue;
+				secondary = (vulkan_secondary_command_buffer*)secondaries[i]->internal_data;
+			}
+
+			for (u32 j = 0; j < darray_length(secondary->renderstages); ++j)
+				vulkan_renderer_wait_barriers(context, submission, secondary->renderstages[j]);
+
+			handles[handle_count++] = secondary->command_buffer.handle;
+		}
+
+		if (handle_count > 0) {
+			vkCmdExecuteCommands(submission->command_buffer->handle, handle_count, handles);
+
+			// State bound on the primary command buffer is undefined after executing secondaries.
+			bzero_memory(&submission->command_buffer->bound, sizeof(vulkan_bound_state));
+		}
+		break;
+
     case RENDERCMD_DISPATCH:
-        vkCmdDispatch(curr_submission->command_buffer->handle,
+        vkCmdDispatch(submission->command_buffer->handle,
                       payload->dispatch.group_size.x,
                       payload->dispatch.group_size.y,
                       payload->dispatch.group_size.z);
         break;
 
+    case RENDERCMD_DISPATCH_INDIRECT:
+        vkCmdDispatchIndirect(submission->command_buffer->handle,
+                              ((internal_vulkan_renderbuffer*)payload->dispatch_indirect.buffer->internal_data)->handle,
+                              payload->dispatch_indirect.offset);
+        break;
+
     case RENDERCMD_END:
         if (rendercmd_context->current_target)
             vulkan_rendertarget_end(
-                context, curr_submission->command_buffer,
+                context, submission->command_buffer,
                 rendercmd_context->current_target);
         break;
     }
 }
 
+void vulkan_renderer_execute_command(box_renderer_backend* backend, box_rendercmd_context* rendercmd_context, rendercmd_header* header, rendercmd_payload* payload) {
+	BX_ASSERT(backend != NULL && rendercmd_context != NULL && header != NULL && payload != NULL && "Invalid arguments passed to vulkan_renderer_execute_command");
+    vulkan_context* context = (vulkan_context*)backend->internal_context;
+	FRAME_PATH_BEGIN();
+
+	if (rendercmd_context->current_mode != context->last_mode && 
+		!vulkan_renderer_begin_submission(context, rendercmd_context->current_mode))
+		return;
+
+	vulkan_queue_submission* submission = &context->queued_submissions[darray_length(context->queued_submissions) - 1];
+	vulkan_renderer_record_command(backend, context, rendercmd_context, submission, header, payload);
+	FRAME_PATH_END(context);
+}
+
+b8 vulkan_renderer_execute_commands(box_renderer_backend* backend, box_rendercmd_context* rendercmd_context, box_rendercmd* rendercmd) {
+	BX_ASSERT(backend != NULL && rendercmd_context != NULL && rendercmd != NULL && "Invalid arguments passed to vulkan_renderer_execute_commands");
+    vulkan_context* context = (vulkan_context*)backend->internal_context;
+	FRAME_PATH_BEGIN();
+
+	// The submission is only looked up again when the mode changes.
+	vulkan_queue_submission* submission = darray_length(context->queued_submissions) > 0 ?
+		&context->queued_submissions[darray_length(context->queued_submissions) - 1] : NULL;
+
+	u8* cursor = 0;
+	while (freelist_next_block(&rendercmd->buffer, &cursor)) {
+		rendercmd_header* header = (rendercmd_header*)cursor;
+		rendercmd_payload* payload = (rendercmd_payload*)(cursor + sizeof(rendercmd_header));
+
+		if (rendercmd_context_skip_command(rendercmd_context, header, payload))
+			continue;
+
+		if (header->supported_mode && header->supported_mode != context->last_mode) {
+			rendercmd_context->current_mode = header->supported_mode;
+			submission = vulkan_renderer_begin_submission(context, header->supported_mode);
+			if (!submission) return FALSE;
+		}
+
+		BX_ASSERT(submission != NULL && "Render command recorded before any command selecting a renderer mode");
+		vulkan_renderer_record_command(backend, context, rendercmd_context, submission, header, payload);
+	}
+
+	FRAME_PATH_END(context);
+	return TRUE;
+}
+
 b8 vulkan_renderer_backend_end_frame(box_renderer_backend* backend) {
 	BX_ASSERT(backend != NULL && "Invalid arguments passed to vulkan_renderer_backend_end_frame");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
+	FRAME_PATH_BEGIN();
 
 	VkSemaphore render_complete_semaphore;
 
 	if (backend->platform != NULL) {
 		vulkan_window_system* window_system = (vulkan_window_system*)backend->platform->internal_renderer_state;
-		darray_push(context->queued_submissions[0].wait_semaphores, window_system->image_available_semaphores[context->current_frame]);
+		vulkan_queue_submission_add_wait(
+			&context->queued_submissions[0],
+			window_system->image_available_semaphores[context->current_frame],
+			darray_length(context->semaphore_pool) + 1);
 	}
 
 	for (u32 i = 0; i < darray_length(context->queued_submissions); ++i) {
@@ -544,25 +1151,21 @@ b8 vulkan_renderer_backend_end_frame(box_renderer_backend* backend) {
 			vulkan_command_buffer_end(submission->command_buffer), 
 			"Failed to end Vulkan command buffer");
 
-		// TODO: Propbably change this at some point...
-		VkPipelineStageFlags wait_flags[] = { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
-
 		if (i == darray_length(context->queued_submissions) - 1)
 			signal_fence = context->in_flight_fences[context->current_frame];
 		
 		CHECK_VKRESULT(
 			vulkan_command_buffer_submit(
 				submission->command_buffer,
-				darray_length(submission->wait_semaphores), 
+				submission->wait_semaphore_count, 
 				submission->wait_semaphores, 
 				1, 
 				&submission->signal_semaphore,
-				wait_flags,
+				submission->wait_stages,
 				signal_fence),
 			"Failed to submit Vulkan command buffer");
 		
 		render_complete_semaphore = submission->signal_semaphore;
-		darray_destroy(submission->wait_semaphores);
 	}
 
 	if (backend->platform != NULL) {
@@ -578,7 +1181,17 @@ b8 vulkan_renderer_backend_end_frame(box_renderer_backend* backend) {
 			"Failed to present Vulkan swapchain image");
 	}	
 
+	FRAME_PATH_END(context);
+
+#if BOX_ENABLE_DIAGNOSTICS
+	// Once the per-frame buffers have grown, beginning, recording and submitting a frame must not allocate.
+	u64 frame_allocations = atomic_exchange_u64(&context->frame_path_allocations, 0);
+	if (frame_allocations > 0 && context->frame_number >= VULKAN_WARMUP_FRAMES(context))
+		BX_WARN("Steady state frame %llu made %llu heap allocations in the Vulkan backend", context->frame_number, frame_allocations);
+#endif
+
 	// Advance to next frame
     context->current_frame = (context->current_frame + 1) % context->config.frames_in_flight;
+	context->frame_number++;
     return TRUE;
 }
\ No newline at end of file
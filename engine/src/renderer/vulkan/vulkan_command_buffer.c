@@ -37,6 +37,28 @@ VkResult vulkan_command_buffer_begin(
     if (is_renderpass_continue) begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
     if (is_simultaneous_use)    begin_info.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 
+    bzero_memory(&command_buffer->bound, sizeof(vulkan_bound_state));
+    return vkBeginCommandBuffer(
+            command_buffer->handle, 
+            &begin_info);
+}
+
+VkResult vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass render_pass,
+    VkFramebuffer framebuffer,
+    b8 is_single_use) {
+    VkCommandBufferInheritanceInfo inheritance_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritance_info.renderPass = render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo begin_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    if (is_single_use) begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    bzero_memory(&command_buffer->bound, sizeof(vulkan_bound_state));
     return vkBeginCommandBuffer(
             command_buffer->handle, 
             &begin_info);
@@ -22,6 +22,14 @@ VkResult vulkan_command_buffer_begin(
     b8 is_renderpass_continue,
     b8 is_simultaneous_use);
 
+// Begins recording a secondary command buffer that continues the given render pass.
+// The framebuffer may be VK_NULL_HANDLE when the command buffer is executed with different framebuffers.
+VkResult vulkan_command_buffer_begin_secondary(
+    vulkan_command_buffer* command_buffer,
+    VkRenderPass render_pass,
+    VkFramebuffer framebuffer,
+    b8 is_single_use);
+
 // Ends recording of a command buffer.
 VkResult vulkan_command_buffer_end(
     vulkan_command_buffer* command_buffer);
@@ -64,7 +64,30 @@ VkResult vulkan_device_create(box_renderer_backend* backend) {
     VkPhysicalDeviceFeatures device_features = {};
     device_features.samplerAnisotropy = context->config.sampler_anisotropy;  // Request anisotropy
 
+    // Indirect draw features are enabled whenever the device has them.
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(context->device.physical_device, &supported_features);
+    device_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+    device_features.drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance;
+    context->device.multi_draw_indirect = backend->capabilities.multi_draw_indirect;
+    context->device.draw_indirect_count = backend->capabilities.draw_indirect_count;
+
     VkDeviceCreateInfo device_create_info = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+
+    VkPhysicalDeviceVulkan12Features vulkan12_features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    vulkan12_features.drawIndirectCount = backend->capabilities.draw_indirect_count;
+    if (backend->capabilities.draw_indirect_count) {
+        vulkan12_features.pNext = (void*)device_create_info.pNext;
+        device_create_info.pNext = &vulkan12_features;
+    }
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT uint8_features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT };
+    uint8_features.indexTypeUint8 = backend->capabilities.index_type_uint8;
+    if (backend->capabilities.index_type_uint8) {
+        darray_push(required_extensions, VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+        uint8_features.pNext = (void*)device_create_info.pNext;
+        device_create_info.pNext = &uint8_features;
+    }
     device_create_info.queueCreateInfoCount = darray_length(queue_create_info);
     device_create_info.pQueueCreateInfos = queue_create_info;
     device_create_info.pEnabledFeatures = &device_features;
@@ -196,6 +219,19 @@ b8 physical_device_meets_requirements(
 
     out_capabilities->device_type = (box_renderer_device_type)properties.deviceType;
     out_capabilities->max_anisotropy = features.samplerAnisotropy;
+    out_capabilities->multi_draw_indirect = features.multiDrawIndirect;
+    out_capabilities->max_push_constant_size = properties.limits.maxPushConstantsSize;
+
+    // Indirect count draws are core since Vulkan 1.2, only queried on devices supporting it.
+    out_capabilities->draw_indirect_count = FALSE;
+    if (properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceVulkan12Features vulkan12_features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+        VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        features2.pNext = &vulkan12_features;
+
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        out_capabilities->draw_indirect_count = vulkan12_features.drawIndirectCount;
+    }
 
     if (out_capabilities->device_name)
         bfree(out_capabilities->device_name, string_length(out_capabilities->device_name) + 1, MEMORY_TAG_RENDERER);
@@ -284,6 +320,20 @@ b8 physical_device_meets_requirements(
             }
         }
 
+        // 8-bit indices come from an optional extension, enabled whenever the device has it.
+        out_capabilities->index_type_uint8 = FALSE;
+        for (u32 i = 0; i < darray_length(supported_extensions); ++i) {
+            if (!strings_equal(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME, supported_extensions[i].extensionName)) continue;
+
+            VkPhysicalDeviceIndexTypeUint8FeaturesEXT uint8_features = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT };
+            VkPhysicalDeviceFeatures2 features2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+            features2.pNext = &uint8_features;
+
+            vkGetPhysicalDeviceFeatures2(device, &features2);
+            out_capabilities->index_type_uint8 = uint8_features.indexTypeUint8;
+            break;
+        }
+
         darray_destroy(supported_extensions);
 
         // Sampler anisotropy
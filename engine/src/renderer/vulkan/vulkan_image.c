@@ -1,6 +1,8 @@
 #include "defines.h"
 #include "vulkan_image.h"
 
+#include "vulkan_memory.h"
+
 VkResult vulkan_image_create(
     vulkan_context* context, 
     uvec2 size, 
@@ -31,23 +33,15 @@ VkResult vulkan_image_create(
     VkMemoryRequirements memory_requirements;
     vkGetImageMemoryRequirements(context->device.logical_device, out_image->handle, &memory_requirements);
 
-    i32 memory_index = find_memory_index(context, memory_requirements.memoryTypeBits, memory_flags);
-    if (memory_index == -1) {
-        BX_ERROR("Required memory type not found. Image not valid.");
-        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    result = vulkan_memory_allocate(context, &memory_requirements, memory_flags, FALSE, &out_image->allocation);
+    if (!vulkan_result_is_success(result)) {
+        BX_ERROR("Required memory could not be allocated. Image not valid.");
+        return result;
     }
 
-    // Allocate memory
-    VkMemoryAllocateInfo memory_allocate_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    memory_allocate_info.allocationSize = memory_requirements.size;
-    memory_allocate_info.memoryTypeIndex = memory_index;
-
-    result = vkAllocateMemory(context->device.logical_device, &memory_allocate_info, context->allocator, &out_image->memory);
-    if (!vulkan_result_is_success(result)) return FALSE;
-
     // Bind the memory
-    result = vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->memory, 0);
-    if (!vulkan_result_is_success(result)) return FALSE;
+    result = vkBindImageMemory(context->device.logical_device, out_image->handle, out_image->allocation.memory, out_image->allocation.offset);
+    if (!vulkan_result_is_success(result)) return result;
 
     VkImageViewCreateInfo view_create_info = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
     view_create_info.image = out_image->handle;
@@ -132,8 +126,8 @@ void vulkan_image_destroy(
         if (image->view)
             vkDestroyImageView(context->device.logical_device, image->view, context->allocator);
         
-        if (image->memory && ownes_image)
-            vkFreeMemory(context->device.logical_device, image->memory, context->allocator);
+        if (ownes_image)
+            vulkan_memory_free(context, &image->allocation);
 
         if (image->handle && ownes_image)
             vkDestroyImage(context->device.logical_device, image->handle, context->allocator);
@@ -0,0 +1,153 @@
+#include "defines.h"
+#include "vulkan_memory.h"
+
+#include "utils/darray.h"
+
+// Size in bytes of the device memory blocks shared between resources.
+#define VULKAN_MEMORY_BLOCK_SIZE (64ULL * 1024 * 1024)
+
+// Requests above this size get a block of their own instead of fragmenting a shared one.
+#define VULKAN_MEMORY_DEDICATED_THRESHOLD (VULKAN_MEMORY_BLOCK_SIZE / 2)
+
+vulkan_memory_block* vulkan_memory_create_block(
+    vulkan_context* context,
+    u32 memory_type,
+    b8 linear,
+    u64 size,
+    b8 dedicated) {
+    VkMemoryAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = memory_type;
+
+    VkDeviceMemory handle = VK_NULL_HANDLE;
+    VkResult result = vkAllocateMemory(context->device.logical_device, &alloc_info, context->allocator, &handle);
+    if (!vulkan_result_is_success(result)) return NULL;
+
+    // Mapping follows the memory type rather than the request, later requests for host visible memory
+    // may land in this block when the device reports the same type for them.
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    vkGetPhysicalDeviceMemoryProperties(context->device.physical_device, &memory_properties);
+
+    void* mapped = NULL;
+    if (memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = vkMapMemory(context->device.logical_device, handle, 0, VK_WHOLE_SIZE, 0, &mapped);
+        if (!vulkan_result_is_success(result)) {
+            vkFreeMemory(context->device.logical_device, handle, context->allocator);
+            return NULL;
+        }
+    }
+
+    vulkan_memory_block* block = ballocate(sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+    block->handle = handle;
+    block->size = size;
+    block->memory_type = memory_type;
+    block->linear = linear;
+    block->dedicated = dedicated;
+    block->mapped = mapped;
+    range_allocator_create(size, MEMORY_TAG_RENDERER, &block->ranges);
+
+    if (!context->memory_blocks)
+        context->memory_blocks = darray_create(vulkan_memory_block*, MEMORY_TAG_RENDERER);
+
+    darray_push(context->memory_blocks, block);
+    return block;
+}
+
+void vulkan_memory_destroy_block(
+    vulkan_context* context,
+    vulkan_memory_block* block) {
+    if (block->mapped)
+        vkUnmapMemory(context->device.logical_device, block->handle);
+
+    vkFreeMemory(context->device.logical_device, block->handle, context->allocator);
+    range_allocator_destroy(&block->ranges);
+    bfree(block, sizeof(vulkan_memory_block), MEMORY_TAG_RENDERER);
+}
+
+VkResult vulkan_memory_allocate(
+    vulkan_context* context,
+    VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags properties,
+    b8 linear,
+    vulkan_allocation* out_allocation) {
+    BX_ASSERT(context != NULL && requirements != NULL && out_allocation != NULL && "Invalid arguments passed to vulkan_memory_allocate");
+
+    i32 memory_index = find_memory_index(context, requirements->memoryTypeBits, properties);
+    if (memory_index == -1) {
+        BX_ERROR("vulkan_memory_allocate(): Unable to find suitable memory type.");
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    }
+
+    vulkan_memory_block* block = NULL;
+    range_allocation range = {};
+
+    if (requirements->size > VULKAN_MEMORY_DEDICATED_THRESHOLD) {
+        block = vulkan_memory_create_block(context, (u32)memory_index, linear, requirements->size, TRUE);
+        if (!block) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+        range_allocator_allocate(&block->ranges, requirements->size, 1, &range);
+    }
+    else {
+        // First fit over the existing blocks, most resources land in the first one or two.
+        u32 block_count = context->memory_blocks ? (u32)darray_length(context->memory_blocks) : 0;
+        for (u32 i = 0; i < block_count; ++i) {
+            vulkan_memory_block* candidate = context->memory_blocks[i];
+            if (candidate->dedicated || candidate->memory_type != (u32)memory_index || candidate->linear != linear) continue;
+
+            if (range_allocator_allocate(&candidate->ranges, requirements->size, requirements->alignment, &range)) {
+                block = candidate;
+                break;
+            }
+        }
+
+        if (!block) {
+            block = vulkan_memory_create_block(context, (u32)memory_index, linear, VULKAN_MEMORY_BLOCK_SIZE, FALSE);
+            if (!block) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+            range_allocator_allocate(&block->ranges, requirements->size, requirements->alignment, &range);
+        }
+    }
+
+    out_allocation->memory = block->handle;
+    out_allocation->offset = range.offset;
+    out_allocation->size = range.size;
+    out_allocation->mapped = block->mapped ? (u8*)block->mapped + range.offset : NULL;
+    out_allocation->block = block;
+    out_allocation->range = range;
+    return VK_SUCCESS;
+}
+
+void vulkan_memory_free(
+    vulkan_context* context,
+    vulkan_allocation* allocation) {
+    BX_ASSERT(context != NULL && allocation != NULL && "Invalid arguments passed to vulkan_memory_free");
+
+    vulkan_memory_block* block = allocation->block;
+    if (!block) return;
+
+    range_allocator_free(&block->ranges, &allocation->range);
+    bzero_memory(allocation, sizeof(vulkan_allocation));
+
+    if (!block->dedicated) return;
+
+    for (u32 i = 0; i < darray_length(context->memory_blocks); ++i) {
+        if (context->memory_blocks[i] != block) continue;
+
+        darray_swap_remove(context->memory_blocks, i, NULL);
+        break;
+    }
+
+    vulkan_memory_destroy_block(context, block);
+}
+
+void vulkan_memory_shutdown(
+    vulkan_context* context) {
+    BX_ASSERT(context != NULL && "Invalid arguments passed to vulkan_memory_shutdown");
+    if (!context->memory_blocks) return;
+
+    for (u32 i = 0; i < darray_length(context->memory_blocks); ++i)
+        vulkan_memory_destroy_block(context, context->memory_blocks[i]);
+
+    darray_destroy(context->memory_blocks);
+    context->memory_blocks = NULL;
+}
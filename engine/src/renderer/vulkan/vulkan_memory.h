@@ -0,0 +1,22 @@
+#pragma once
+
+#include "defines.h"
+#include "vulkan_types.h"
+
+// Suballocates device memory for a resource from a shared block of a matching memory type, creating blocks as needed.
+// Requests too large to share a block get a dedicated one. Host visible memory comes back persistently mapped.
+VkResult vulkan_memory_allocate(
+    vulkan_context* context,
+    VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags properties,
+    b8 linear,
+    vulkan_allocation* out_allocation);
+
+// Returns an allocation to its block. The resource bound to it must no longer be in use.
+void vulkan_memory_free(
+    vulkan_context* context,
+    vulkan_allocation* allocation);
+
+// Releases every device memory block. All allocations must have been freed.
+void vulkan_memory_shutdown(
+    vulkan_context* context);
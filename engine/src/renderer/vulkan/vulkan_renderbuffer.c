@@ -2,8 +2,11 @@
 #include "vulkan_renderbuffer.h"
 
 #include "vulkan_command_buffer.h"
+#include "vulkan_memory.h"
 #include "vulkan_renderbuffer.h"
 
+#include "platform/threading.h"
+
 VkBufferUsageFlags get_vulkan_renderbuffer_usage(
     vulkan_context* context,
 	box_renderbuffer_config* config) {
@@ -18,6 +21,10 @@ VkBufferUsageFlags get_vulkan_renderbuffer_usage(
 		buffer_usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	if (config->usage & BOX_RENDERBUFFER_USAGE_CPU_VISIBLE)
 		buffer_usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	if (config->usage & BOX_RENDERBUFFER_USAGE_INDIRECT)
+		buffer_usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+	if (config->usage & BOX_RENDERBUFFER_USAGE_UNIFORM)
+		buffer_usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     
     return buffer_usage;
 }
@@ -39,12 +46,20 @@ b8 vulkan_renderbuffer_create(
 		BX_ERROR("vulkan_renderbuffer_create(): Cannot create a render buffer with no usage set");
 		return FALSE;
 	}
+
+	if ((config->usage & BOX_RENDERBUFFER_USAGE_INDEX) && config->index_type == BOX_INDEX_TYPE_UINT8 && !backend->capabilities.index_type_uint8) {
+		BX_ERROR("vulkan_renderbuffer_create(): Device does not support 8-bit index buffers");
+		return FALSE;
+	}
 #endif
 
-    out_buffer->internal_data = ballocate(sizeof(internal_vulkan_renderbuffer), MEMORY_TAG_RENDERER);
+    out_buffer->internal_data = pool_allocator_allocate(&context->renderbuffer_pool);
     internal_vulkan_renderbuffer* internal_buffer = (internal_vulkan_renderbuffer*)out_buffer->internal_data;
+	internal_buffer->generation = ++context->resource_generation;
 
 	out_buffer->buffer_size = config->buffer_size;
+	out_buffer->usage = config->usage;
+	out_buffer->index_type = config->index_type;
 	
     internal_buffer->properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 	if (config->usage & BOX_RENDERBUFFER_USAGE_CPU_VISIBLE)
@@ -58,21 +73,17 @@ b8 vulkan_renderbuffer_create(
 	if (!vulkan_result_is_success(result)) return FALSE;
 
 	vkGetBufferMemoryRequirements(context->device.logical_device, internal_buffer->handle, &internal_buffer->memory_requirements);
-	i32 memory_index = find_memory_index(context, internal_buffer->memory_requirements.memoryTypeBits, internal_buffer->properties);
-
-    if (memory_index == -1) {
-		BX_ERROR("vulkan_renderbuffer_create(): Unable to find suitable memory type for renderbuffer.");
+	result = vulkan_memory_allocate(context, &internal_buffer->memory_requirements, internal_buffer->properties, TRUE, &internal_buffer->allocation);
+	if (!vulkan_result_is_success(result)) {
+		BX_ERROR("vulkan_renderbuffer_create(): Unable to allocate memory for renderbuffer.");
 		return FALSE;
 	}
 
-    VkMemoryAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-	alloc_info.allocationSize = internal_buffer->memory_requirements.size;
-	alloc_info.memoryTypeIndex = memory_index;
-
-	result = vkAllocateMemory(context->device.logical_device, &alloc_info, context->allocator, &internal_buffer->memory);
-	if (!vulkan_result_is_success(result)) return FALSE;
-
-    result = vkBindBufferMemory(context->device.logical_device, internal_buffer->handle, internal_buffer->memory, 0);
+    result = vkBindBufferMemory(
+		context->device.logical_device, 
+		internal_buffer->handle, 
+		internal_buffer->allocation.memory, 
+		internal_buffer->allocation.offset);
     if (!vulkan_result_is_success(result)) return FALSE;
     return TRUE;
 }
@@ -139,21 +150,22 @@ b8 vulkan_renderbuffer_map_data(
     u64 buf_offset, 
 	u64 buf_size) {
 	BX_ASSERT(backend != NULL && buffer != NULL && source != NULL && "Invalid arguments passed to vulkan_renderbuffer_map_data");
-    vulkan_context* context = (vulkan_context*)backend->internal_context;
 
     internal_vulkan_renderbuffer* internal_buffer = (internal_vulkan_renderbuffer*)buffer->internal_data;
 
-    void* map_ptr = NULL;
-	CHECK_VKRESULT(
-		vkMapMemory(
-			context->device.logical_device, 
-			internal_buffer->memory, 
-			buf_offset, buf_size, 
-			0, &map_ptr),
-		"Failed to map data to Vulkan buffer");
-
-	bcopy_memory(map_ptr, source, buf_size);
-	vkUnmapMemory(context->device.logical_device, internal_buffer->memory);
+	if (!internal_buffer->allocation.mapped) {
+		BX_ERROR("vulkan_renderbuffer_map_data(): Attempting to map data to a renderbuffer that is not CPU visible.");
+		return FALSE;
+	}
+
+	if (buf_offset > buffer->buffer_size || buf_size > buffer->buffer_size - buf_offset) {
+		BX_ERROR("vulkan_renderbuffer_map_data(): Range (offset %llu, size %llu) is outside of the %llu byte renderbuffer.", 
+			buf_offset, buf_size, buffer->buffer_size);
+		return FALSE;
+	}
+
+	// Host visible memory stays mapped for the lifetime of its block.
+	bcopy_memory((u8*)internal_buffer->allocation.mapped + buf_offset, source, buf_size);
 	return TRUE;
 }	
 
@@ -170,9 +182,58 @@ void vulkan_renderbuffer_destroy(
 		if (internal_buffer->handle)
 			vkDestroyBuffer(context->device.logical_device, internal_buffer->handle, context->allocator);
 
-		if (internal_buffer->memory)
-			vkFreeMemory(context->device.logical_device, internal_buffer->memory, context->allocator);
+		vulkan_memory_free(context, &internal_buffer->allocation);
 
-		bfree(internal_buffer, sizeof(internal_vulkan_renderbuffer), MEMORY_TAG_RENDERER);
+		pool_allocator_free(&context->renderbuffer_pool, internal_buffer);
 	}
-}
\ No newline at end of file
+}
+
+b8 vulkan_uniform_ring_create(
+	box_renderer_backend* backend,
+	u64 frame_size) {
+	BX_ASSERT(backend != NULL && "Invalid arguments passed to vulkan_uniform_ring_create");
+    vulkan_context* context = (vulkan_context*)backend->internal_context;
+	vulkan_uniform_ring* ring = &context->uniform_ring;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(context->device.physical_device, &properties);
+
+	ring->alignment = properties.limits.minUniformBufferOffsetAlignment;
+	ring->frame_size = alignment(frame_size, ring->alignment);
+	ring->head = 0;
+
+	box_renderbuffer_config config = box_renderbuffer_default();
+	config.usage = BOX_RENDERBUFFER_USAGE_UNIFORM | BOX_RENDERBUFFER_USAGE_CPU_VISIBLE;
+	config.buffer_size = ring->frame_size * context->config.frames_in_flight;
+	return vulkan_renderbuffer_create(backend, &config, &ring->buffer);
+}
+
+u64 vulkan_uniform_ring_push(
+	vulkan_context* context,
+	const void* data,
+	u64 size,
+	u64 range) {
+	vulkan_uniform_ring* ring = &context->uniform_ring;
+
+	// Reserving the whole range keeps the descriptor inside the region even for smaller data.
+	u64 reserved = alignment(range, ring->alignment);
+	u64 end = atomic_add_u64(&ring->head, reserved);
+	if (end > ring->frame_size) {
+		BX_ERROR("vulkan_uniform_ring_push(): Uniform ring out of memory, raise uniform_ring_size above %llu bytes.", ring->frame_size);
+		return UINT64_MAX;
+	}
+
+	u64 offset = ring->frame_size * context->current_frame + end - reserved;
+	internal_vulkan_renderbuffer* internal_buffer = (internal_vulkan_renderbuffer*)ring->buffer.internal_data;
+	bcopy_memory((u8*)internal_buffer->allocation.mapped + offset, data, size);
+	return offset;
+}
+
+void vulkan_uniform_ring_destroy(
+	box_renderer_backend* backend) {
+	BX_ASSERT(backend != NULL && "Invalid arguments passed to vulkan_uniform_ring_destroy");
+    vulkan_context* context = (vulkan_context*)backend->internal_context;
+
+	vulkan_renderbuffer_destroy(backend, &context->uniform_ring.buffer);
+	bzero_memory(&context->uniform_ring, sizeof(vulkan_uniform_ring));
+}
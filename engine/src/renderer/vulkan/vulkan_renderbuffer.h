@@ -25,4 +25,20 @@ b8 vulkan_renderbuffer_map_data(
 
 void vulkan_renderbuffer_destroy(
 	box_renderer_backend* backend,
-	box_renderbuffer* buffer);
\ No newline at end of file
+	box_renderbuffer* buffer);
+
+// Creates the uniform ring with a region of 'frame_size' bytes for each frame in flight.
+b8 vulkan_uniform_ring_create(
+	box_renderer_backend* backend,
+	u64 frame_size);
+
+// Copies 'size' bytes into the region of the current frame, reserving 'range' bytes for the descriptor reading them.
+// Returns the offset within the ring buffer, or UINT64_MAX when the region is full. Safe to call from several threads.
+u64 vulkan_uniform_ring_push(
+	vulkan_context* context,
+	const void* data,
+	u64 size,
+	u64 range);
+
+void vulkan_uniform_ring_destroy(
+	box_renderer_backend* backend);
@@ -3,6 +3,58 @@
 
 #include "utils/darray.h"
 
+#include "vulkan_renderbuffer.h"
+
+VkResult vulkan_renderstage_write_dynamic_uniforms(
+    vulkan_context* context,
+    box_renderstage_layout* config,
+    internal_vulkan_renderstage* internal_renderstage) {
+    DARRAY_INLINE_STORAGE(write_storage, VkWriteDescriptorSet, 16);
+    VkWriteDescriptorSet* write_commands = darray_create_inline(VkWriteDescriptorSet, write_storage, MEMORY_TAG_RENDERER);
+    VkDescriptorBufferInfo* buffer_infos = darray_reserve(VkDescriptorBufferInfo, config->descriptor_count, MEMORY_TAG_RENDERER);
+
+    for (u32 i = 0; i < config->descriptor_count; ++i) {
+        box_descriptor_desc* descriptor = &config->descriptors[i];
+        if (descriptor->descriptor_type != BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) continue;
+
+        // Checked in every build, recording and binding index fixed size arrays by dynamic_uniform_count.
+        if (!context->uniform_ring.buffer.internal_data || descriptor->uniform_size == 0 || 
+            descriptor->uniform_size > context->uniform_ring.frame_size ||
+            internal_renderstage->dynamic_uniform_count == VULKAN_MAX_DYNAMIC_UNIFORMS) {
+            BX_ERROR("vulkan_renderstage_create_layout(): Dynamic uniform buffer at binding %u needs a uniform size, a uniform ring large enough and at most %u such buffers per renderstage.",
+                descriptor->binding, VULKAN_MAX_DYNAMIC_UNIFORMS);
+            darray_destroy(buffer_infos);
+            darray_destroy(write_commands);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+
+        internal_renderstage->dynamic_uniform_count++;
+
+        VkDescriptorBufferInfo* buffer_info = darray_push_empty(buffer_infos);
+        buffer_info->buffer = ((internal_vulkan_renderbuffer*)context->uniform_ring.buffer.internal_data)->handle;
+        buffer_info->offset = 0;
+        buffer_info->range  = descriptor->uniform_size;
+
+        for (u32 j = 0; j < context->config.frames_in_flight; ++j) {
+            VkWriteDescriptorSet* descriptor_write = darray_push_empty(write_commands);
+            bzero_memory(descriptor_write, sizeof(VkWriteDescriptorSet));
+            descriptor_write->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptor_write->dstSet          = internal_renderstage->descriptor_sets[j];
+            descriptor_write->dstBinding      = descriptor->binding;
+            descriptor_write->descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            descriptor_write->descriptorCount = 1;
+            descriptor_write->pBufferInfo     = buffer_info;
+        }
+    }
+
+    if (darray_length(write_commands) > 0)
+        vkUpdateDescriptorSets(context->device.logical_device, darray_length(write_commands), write_commands, 0, NULL);
+
+    darray_destroy(buffer_infos);
+    darray_destroy(write_commands);
+    return VK_SUCCESS;
+}
+
 VkResult vulkan_renderstage_create_layout(
     vulkan_context* context,
     VkPipelineShaderStageCreateInfo** out_shader_stages,
@@ -30,8 +82,10 @@ VkResult vulkan_renderstage_create_layout(
     // Setup descriptor layout / memory for renderstage
     if (config->descriptor_count > 0) {
         // Collect descriptor data into vulkan structs.
-		VkDescriptorSetLayoutBinding* descriptor_bindings = darray_reserve(VkDescriptorSetLayoutBinding, config->descriptor_count, MEMORY_TAG_RENDERER);
-		VkDescriptorPoolSize* descriptor_pools = darray_reserve(VkDescriptorPoolSize, config->descriptor_count, MEMORY_TAG_RENDERER);
+		DARRAY_INLINE_STORAGE(binding_storage, VkDescriptorSetLayoutBinding, 16);
+		DARRAY_INLINE_STORAGE(pool_storage, VkDescriptorPoolSize, 16);
+		VkDescriptorSetLayoutBinding* descriptor_bindings = darray_create_inline(VkDescriptorSetLayoutBinding, binding_storage, MEMORY_TAG_RENDERER);
+		VkDescriptorPoolSize* descriptor_pools = darray_create_inline(VkDescriptorPoolSize, pool_storage, MEMORY_TAG_RENDERER);
 
         for (u32 i = 0; i < config->descriptor_count; ++i) {
 			VkDescriptorSetLayoutBinding* binding = darray_push_empty(descriptor_bindings);
@@ -51,7 +105,6 @@ VkResult vulkan_renderstage_create_layout(
 		layoutInfo.bindingCount = darray_length(descriptor_bindings);
 		layoutInfo.pBindings = descriptor_bindings;
 		VkResult result = vkCreateDescriptorSetLayout(context->device.logical_device, &layoutInfo, context->allocator, &internal_renderstage->descriptor);
-		if (!vulkan_result_is_success(result)) return result;
         // ------------------------------------------
 
         // Create descriptor pool.
@@ -60,14 +113,20 @@ VkResult vulkan_renderstage_create_layout(
 		pool_info.pPoolSizes = descriptor_pools;
 		pool_info.maxSets = context->config.frames_in_flight;
 
-		result = vkCreateDescriptorPool(context->device.logical_device, &pool_info, context->allocator, &internal_renderstage->descriptor_pool);
+		if (vulkan_result_is_success(result))
+			result = vkCreateDescriptorPool(context->device.logical_device, &pool_info, context->allocator, &internal_renderstage->descriptor_pool);
+
+		// Bindings and pool sizes are only needed to create the layout and pool.
+		darray_destroy(descriptor_pools);
+		darray_destroy(descriptor_bindings);
 		if (!vulkan_result_is_success(result)) return result;
         // ------------------------------------------
 
         // Create descriptor sets per frame in flight.
 		internal_renderstage->descriptor_sets = darray_reserve(VkDescriptorSet, context->config.frames_in_flight, MEMORY_TAG_RENDERER);
 
-        VkDescriptorSetLayout* layouts = darray_reserve(VkDescriptorSetLayout, context->config.frames_in_flight, MEMORY_TAG_RENDERER);
+		DARRAY_INLINE_STORAGE(layout_storage, VkDescriptorSetLayout, 4);
+        VkDescriptorSetLayout* layouts = darray_create_inline(VkDescriptorSetLayout, layout_storage, MEMORY_TAG_RENDERER);
 		for (u32 i = 0; i < context->config.frames_in_flight; ++i)
 			darray_push(layouts, internal_renderstage->descriptor);
 
@@ -76,15 +135,37 @@ VkResult vulkan_renderstage_create_layout(
 		alloc_info.descriptorSetCount = darray_length(layouts);
 		alloc_info.pSetLayouts = layouts;
 		result = vkAllocateDescriptorSets(context->device.logical_device, &alloc_info, internal_renderstage->descriptor_sets);
+		darray_destroy(layouts);
 		if (!vulkan_result_is_success(result)) return result;
 
 		darray_length_set(internal_renderstage->descriptor_sets, alloc_info.descriptorSetCount);
         // ------------------------------------------
 
-        // Destory all temp memory...
-		darray_destroy(descriptor_pools);
-		darray_destroy(descriptor_bindings);
-		darray_destroy(layouts);
+        // Point dynamic uniform buffers at the uniform ring, they only move by their dynamic offset from now on.
+        result = vulkan_renderstage_write_dynamic_uniforms(context, config, internal_renderstage);
+        if (!vulkan_result_is_success(result)) return result;
+        // ------------------------------------------
+    }
+
+    // Collect push constant ranges, Vulkan allows a single range per stage.
+    DARRAY_INLINE_STORAGE(range_storage, VkPushConstantRange, BOX_SHADER_STAGE_TYPE_MAX);
+    VkPushConstantRange* push_constant_ranges = darray_create_inline(VkPushConstantRange, range_storage, MEMORY_TAG_RENDERER);
+    VkShaderStageFlags pushed_stages = 0;
+
+    for (u32 i = 0; i < config->push_constant_count; ++i) {
+        VkPushConstantRange* range = darray_push_empty(push_constant_ranges);
+        range->stageFlags = box_shader_type_to_vulkan_type(config->push_constants[i].stage_type);
+        range->offset = config->push_constants[i].offset;
+        range->size = config->push_constants[i].size;
+
+#if BOX_ENABLE_VALIDATION
+        if (pushed_stages & range->stageFlags) {
+            BX_ERROR("vulkan_renderstage_create_layout(): Shader stage %u has more than one push constant range.", config->push_constants[i].stage_type);
+            darray_destroy(push_constant_ranges);
+            return VK_ERROR_INITIALIZATION_FAILED;
+        }
+#endif
+        pushed_stages |= range->stageFlags;
     }
 
     VkPipelineLayoutCreateInfo create_info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
@@ -93,11 +174,17 @@ VkResult vulkan_renderstage_create_layout(
 		create_info.pSetLayouts = &internal_renderstage->descriptor;
 	}
 
-    return vkCreatePipelineLayout(
+    create_info.pushConstantRangeCount = darray_length(push_constant_ranges);
+    create_info.pPushConstantRanges = push_constant_ranges;
+
+    VkResult result = vkCreatePipelineLayout(
         context->device.logical_device,
         &create_info,
         context->allocator,
         &internal_renderstage->layout);
+
+    darray_destroy(push_constant_ranges);
+    return result;
 }
 
 b8 vulkan_renderstage_create_graphic(
@@ -108,14 +195,40 @@ b8 vulkan_renderstage_create_graphic(
 	BX_ASSERT(backend != NULL && config != NULL && bound_rendertarget != NULL && out_renderstage != NULL && "Invalid arguments passed to vulkan_renderstage_create_graphic");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
     
-    out_renderstage->internal_data = ballocate(sizeof(internal_vulkan_renderstage), MEMORY_TAG_RENDERER);
+    out_renderstage->internal_data = pool_allocator_allocate(&context->renderstage_pool);
     internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)out_renderstage->internal_data;
+    internal_renderstage->generation = ++context->resource_generation;
 
     out_renderstage->pipeline_type = RENDERER_MODE_GRAPHICS;
     out_renderstage->descriptors = darray_from_data(box_descriptor_desc, config->layout.descriptor_count, config->layout.descriptors, MEMORY_TAG_RENDERER);
-    internal_renderstage->graphics.vertex_buffer = config->vertex_buffer;
+    out_renderstage->push_constants = darray_from_data(box_push_constant_range, config->layout.push_constant_count, config->layout.push_constants, MEMORY_TAG_RENDERER);
+    out_renderstage->capabilities = &backend->capabilities;
     internal_renderstage->graphics.index_buffer = config->index_buffer;
 
+    // A lone attribute list is shorthand for a single per-vertex binding.
+    box_vertex_binding single_binding = {};
+    box_vertex_binding* bindings = config->vertex_bindings;
+    u32 binding_count = config->vertex_binding_count;
+    if (binding_count == 0 && config->vertex_attribute_count > 0) {
+        single_binding.attribute_count = config->vertex_attribute_count;
+        single_binding.attributes = config->vertex_attributes;
+        single_binding.input_rate = BOX_VERTEX_INPUT_RATE_VERTEX;
+        single_binding.buffer = config->vertex_buffer;
+        bindings = &single_binding;
+        binding_count = 1;
+    }
+
+#if BOX_ENABLE_VALIDATION
+    if (binding_count > BOX_MAX_VERTEX_BINDINGS) {
+        BX_ERROR("vulkan_renderstage_create_graphic(): Graphics renderstage has %u vertex bindings, at most %u are supported.", binding_count, BOX_MAX_VERTEX_BINDINGS);
+        return FALSE;
+    }
+#endif
+
+    internal_renderstage->graphics.vertex_binding_count = binding_count;
+    for (u32 i = 0; i < binding_count; ++i)
+        internal_renderstage->graphics.vertex_buffers[i] = bindings[i].buffer;
+
     VkPipelineShaderStageCreateInfo* shader_stages = darray_create(VkPipelineShaderStageCreateInfo, MEMORY_TAG_RENDERER);
 
     CHECK_VKRESULT(
@@ -152,25 +265,28 @@ b8 vulkan_renderstage_create_graphic(
     scissor.extent.height = bound_rendertarget->size.height;
 
     // Vertex input configuration
-    // Calculate total vertex stride and fill attribute descriptions.   
-    VkVertexInputBindingDescription binding_desc = {};
-    VkVertexInputAttributeDescription* attributes = darray_reserve(VkVertexInputAttributeDescription, config->vertex_attribute_count, MEMORY_TAG_RENDERER);
-
-    u64 attribute_stride = 0;
-    for (u32 i = 0; i < config->vertex_attribute_count; ++i) {
-        box_render_format attribute = config->vertex_attributes[i];
-
-        VkVertexInputAttributeDescription* descriptor = darray_push_empty(attributes);
-        descriptor->binding = 0;
-        descriptor->location = i;
-        descriptor->format = box_render_format_to_vulkan_type(attribute);
-        descriptor->offset = attribute_stride;
-        attribute_stride += box_render_format_size(attribute);
-    }
+    // Calculate the stride of every binding and fill attribute descriptions, locations continue across bindings.
+    VkVertexInputBindingDescription binding_descs[BOX_MAX_VERTEX_BINDINGS] = {};
+    VkVertexInputAttributeDescription* attributes = darray_create(VkVertexInputAttributeDescription, MEMORY_TAG_RENDERER);
+
+    for (u32 i = 0; i < binding_count; ++i) {
+        u64 attribute_stride = 0;
+        for (u32 j = 0; j < bindings[i].attribute_count; ++j) {
+            box_render_format attribute = bindings[i].attributes[j];
+
+            VkVertexInputAttributeDescription* descriptor = darray_push_empty(attributes);
+            descriptor->binding = i;
+            descriptor->location = darray_length(attributes) - 1;
+            descriptor->format = box_render_format_to_vulkan_type(attribute);
+            descriptor->offset = attribute_stride;
+            attribute_stride += box_render_format_size(attribute);
+        }
 
-    binding_desc.binding = 0;
-    binding_desc.stride = attribute_stride;
-    binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_descs[i].binding = i;
+        binding_descs[i].stride = attribute_stride;
+        binding_descs[i].inputRate = bindings[i].input_rate == BOX_VERTEX_INPUT_RATE_INSTANCE ? 
+            VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+    }
 
     // Colour attachments 
     VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
@@ -234,11 +350,11 @@ b8 vulkan_renderstage_create_graphic(
     VkPipelineVertexInputStateCreateInfo vertex_input_state = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
 
     // Only configure if vertex attributes exist
-    if (config->vertex_attribute_count > 0) {
+    if (binding_count > 0) {
         vertex_input_state.vertexAttributeDescriptionCount = darray_length(attributes);
         vertex_input_state.pVertexAttributeDescriptions = attributes;
-        vertex_input_state.vertexBindingDescriptionCount = 1;
-        vertex_input_state.pVertexBindingDescriptions = &binding_desc;
+        vertex_input_state.vertexBindingDescriptionCount = binding_count;
+        vertex_input_state.pVertexBindingDescriptions = binding_descs;
     }
 
     // Input assembly state
@@ -281,11 +397,14 @@ b8 vulkan_renderstage_create_compute(
 	BX_ASSERT(backend != NULL && config != NULL && out_renderstage != NULL && "Invalid arguments passed to vulkan_renderstage_create_compute");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
     
-    out_renderstage->internal_data = ballocate(sizeof(internal_vulkan_renderstage), MEMORY_TAG_RENDERER);
+    out_renderstage->internal_data = pool_allocator_allocate(&context->renderstage_pool);
     internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)out_renderstage->internal_data;
+    internal_renderstage->generation = ++context->resource_generation;
 
     out_renderstage->pipeline_type = RENDERER_MODE_COMPUTE;
     out_renderstage->descriptors = darray_from_data(box_descriptor_desc, config->layout.descriptor_count, config->layout.descriptors, MEMORY_TAG_RENDERER);
+    out_renderstage->push_constants = darray_from_data(box_push_constant_range, config->layout.push_constant_count, config->layout.push_constants, MEMORY_TAG_RENDERER);
+    out_renderstage->capabilities = &backend->capabilities;
     
     VkPipelineShaderStageCreateInfo* shader_stages = darray_create(VkPipelineShaderStageCreateInfo, MEMORY_TAG_RENDERER);
 
@@ -347,6 +466,11 @@ b8 vulkan_renderstage_update_descriptors(
         box_update_descriptors* write = &descriptors[i];
         const box_descriptor_desc* layout_desc = &write->renderstage->descriptors[write->binding];
 
+        if (write->type == BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            BX_ERROR("Dynamic uniform buffer at binding %u is written with box_rendercmd_bind_uniform instead.", write->binding);
+            continue;
+        }
+
         if (write->type != layout_desc->descriptor_type) {
             BX_ERROR("Descriptor type mismatch at binding %u (write=%u, layout=%u)", write->binding, write->type, layout_desc->descriptor_type);
             continue;
@@ -355,6 +479,9 @@ b8 vulkan_renderstage_update_descriptors(
         BX_ASSERT(write->renderstage != NULL && "Malformed data when updating descriptors");
         internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)write->renderstage->internal_data;
 
+        // Command buffers using the descriptor sets become invalid by updating them.
+        internal_renderstage->generation = ++context->resource_generation;
+
         for (u32 j = 0; j < image_count; ++j) {
             VkWriteDescriptorSet* descriptor_write = darray_push_empty(write_commands);
 			descriptor_write->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -403,11 +530,71 @@ b8 vulkan_renderstage_update_descriptors(
     return TRUE;
 }
 
+u64 vulkan_renderstage_generation(box_renderstage* renderstage) {
+    internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)renderstage->internal_data;
+    u64 generation = internal_renderstage->generation;
+
+    // Generations only ever grow, so recreating any of the buffers raises the maximum.
+    if (renderstage->pipeline_type == RENDERER_MODE_GRAPHICS) {
+        box_renderbuffer* index_buffer = internal_renderstage->graphics.index_buffer;
+        if (index_buffer)
+            generation = BX_MAX(generation, ((internal_vulkan_renderbuffer*)index_buffer->internal_data)->generation);
+
+        for (u32 i = 0; i < internal_renderstage->graphics.vertex_binding_count; ++i) {
+            box_renderbuffer* vertex_buffer = internal_renderstage->graphics.vertex_buffers[i];
+            if (!vertex_buffer) continue;
+            generation = BX_MAX(generation, ((internal_vulkan_renderbuffer*)vertex_buffer->internal_data)->generation);
+        }
+    }
+
+    return generation;
+}
+
+// Returns TRUE when 'handle' still has to be bound on top of 'bound', counting the bind as issued or skipped.
+b8 vulkan_renderstage_needs_bind(box_rendercmd_context* rendercmd_context, u64* bound, u64 handle) {
+    b8 needed = *bound != handle;
+    *bound = handle;
+
+    if (rendercmd_context) {
+        if (needed) rendercmd_context->binds_issued++;
+        else rendercmd_context->binds_skipped++;
+    }
+    return needed;
+}
+
+// Binds a vertex buffer at an offset unless the command buffer has exactly that bound already.
+void vulkan_renderstage_bind_vertex_buffer(vulkan_command_buffer* command_buffer, u32 binding, box_renderbuffer* buffer, VkDeviceSize offset, box_rendercmd_context* rendercmd_context) {
+    vulkan_bound_state* bound = &command_buffer->bound;
+    VkBuffer handle = ((internal_vulkan_renderbuffer*)buffer->internal_data)->handle;
+
+    // The same buffer at another offset has to be bound again as well.
+    if (bound->vertex_offsets[binding] != offset) bound->vertex_buffers[binding] = VK_NULL_HANDLE;
+    bound->vertex_offsets[binding] = offset;
+
+    if (vulkan_renderstage_needs_bind(rendercmd_context, (u64*)&bound->vertex_buffers[binding], (u64)handle))
+        vkCmdBindVertexBuffers(command_buffer->handle, binding, 1, &handle, &offset);
+}
+
+// Binds an index buffer at an offset unless the command buffer has exactly that bound already.
+void vulkan_renderstage_bind_index_buffer(vulkan_command_buffer* command_buffer, box_renderbuffer* buffer, VkDeviceSize offset, box_rendercmd_context* rendercmd_context) {
+    vulkan_bound_state* bound = &command_buffer->bound;
+    VkBuffer handle = ((internal_vulkan_renderbuffer*)buffer->internal_data)->handle;
+
+    // The same buffer at another offset has to be bound again as well.
+    if (bound->index_offset != offset) bound->index_buffer = VK_NULL_HANDLE;
+    bound->index_offset = offset;
+
+    if (vulkan_renderstage_needs_bind(rendercmd_context, (u64*)&bound->index_buffer, (u64)handle))
+        vkCmdBindIndexBuffer(command_buffer->handle, handle, offset, box_index_type_to_vulkan_type(buffer->index_type));
+}
+
 void vulkan_renderstage_bind(
     vulkan_context* context, 
     vulkan_command_buffer* command_buffer, 
-    box_renderstage* renderstage) {
+    box_renderstage* renderstage,
+    box_rendercmd_context* rendercmd_context) {
     internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)renderstage->internal_data;
+    vulkan_bound_state* bound = &command_buffer->bound;
 
     VkPipelineBindPoint bind_point = 0;
     switch (renderstage->pipeline_type) {
@@ -419,27 +606,114 @@ void vulkan_renderstage_bind(
             break;
     }
 
-	vkCmdBindPipeline(command_buffer->handle, bind_point, internal_renderstage->handle);
+    if (vulkan_renderstage_needs_bind(rendercmd_context, (u64*)&bound->pipeline, (u64)internal_renderstage->handle))
+        vkCmdBindPipeline(command_buffer->handle, bind_point, internal_renderstage->handle);
+
+    // Sets bound through another pipeline layout can not be relied upon.
+    if (bound->layout != internal_renderstage->layout) {
+        bound->layout = internal_renderstage->layout;
+        bound->descriptor_set = VK_NULL_HANDLE;
+        bzero_memory(bound->dynamic_offsets, sizeof(bound->dynamic_offsets));
+    }
 
-	if (internal_renderstage->descriptor_sets)
-		vkCmdBindDescriptorSets(command_buffer->handle, bind_point, internal_renderstage->layout, 0, 1, &internal_renderstage->descriptor_sets[context->current_frame], 0, 0);
+    if (internal_renderstage->descriptor_sets) {
+        VkDescriptorSet descriptor_set = internal_renderstage->descriptor_sets[context->current_frame];
+        if (vulkan_renderstage_needs_bind(rendercmd_context, (u64*)&bound->descriptor_set, (u64)descriptor_set))
+            vkCmdBindDescriptorSets(
+                command_buffer->handle, bind_point, internal_renderstage->layout, 0, 1, &descriptor_set, 
+                internal_renderstage->dynamic_uniform_count, bound->dynamic_offsets);
+    }
 
     switch (renderstage->pipeline_type) {
         case RENDERER_MODE_GRAPHICS:
-            if (!internal_renderstage->graphics.vertex_buffer) break;
-            VkDeviceSize offset = 0;
-            
-            internal_vulkan_renderbuffer* vertex_buffer = (internal_vulkan_renderbuffer*)internal_renderstage->graphics.vertex_buffer->internal_data;
-            vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &vertex_buffer->handle, &offset);
-
-            if (internal_renderstage->graphics.index_buffer != NULL) {
-                internal_vulkan_renderbuffer* index_buffer = (internal_vulkan_renderbuffer*)internal_renderstage->graphics.index_buffer->internal_data;
-                vkCmdBindIndexBuffer(command_buffer->handle, index_buffer->handle, offset, VK_INDEX_TYPE_UINT16); // TODO: Customize index type?
+            for (u32 i = 0; i < internal_renderstage->graphics.vertex_binding_count; ++i) {
+                if (!internal_renderstage->graphics.vertex_buffers[i]) continue;
+                vulkan_renderstage_bind_vertex_buffer(command_buffer, i, internal_renderstage->graphics.vertex_buffers[i], 0, rendercmd_context);
             }
+
+            if (internal_renderstage->graphics.index_buffer != NULL)
+                vulkan_renderstage_bind_index_buffer(command_buffer, internal_renderstage->graphics.index_buffer, 0, rendercmd_context);
             break;
     }
 }
 
+void vulkan_renderstage_bind_buffers(
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload,
+    box_rendercmd_context* rendercmd_context) {
+    internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)renderstage->internal_data;
+
+    // Missing buffers fall back to the ones the renderstage was created with.
+    u32 binding = payload->bind_buffers.vertex_binding;
+    box_renderbuffer* vertex_buffer = payload->bind_buffers.vertex_buffer ? payload->bind_buffers.vertex_buffer : internal_renderstage->graphics.vertex_buffers[binding];
+    box_renderbuffer* index_buffer = payload->bind_buffers.index_buffer ? payload->bind_buffers.index_buffer : internal_renderstage->graphics.index_buffer;
+
+    if (vertex_buffer)
+        vulkan_renderstage_bind_vertex_buffer(command_buffer, binding, vertex_buffer, payload->bind_buffers.vertex_offset, rendercmd_context);
+    if (index_buffer)
+        vulkan_renderstage_bind_index_buffer(command_buffer, index_buffer, payload->bind_buffers.index_offset, rendercmd_context);
+}
+
+void vulkan_renderstage_push_constants(
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload) {
+    internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)renderstage->internal_data;
+    u32 offset = payload->push_constants.offset;
+    u32 end = offset + payload->push_constants.size;
+
+    // Vulkan wants the stages of every range overlapping the written bytes.
+    VkShaderStageFlags stage_flags = 0;
+    for (u32 i = 0; i < darray_length(renderstage->push_constants); ++i) {
+        box_push_constant_range* range = &renderstage->push_constants[i];
+        if (offset < range->offset + range->size && end > range->offset)
+            stage_flags |= box_shader_type_to_vulkan_type(range->stage_type);
+    }
+
+    vkCmdPushConstants(
+        command_buffer->handle,
+        internal_renderstage->layout,
+        stage_flags,
+        offset,
+        payload->push_constants.size,
+        RENDERCMD_PUSH_CONSTANT_DATA(payload));
+}
+
+void vulkan_renderstage_bind_uniform(
+    vulkan_context* context,
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload) {
+    internal_vulkan_renderstage* internal_renderstage = (internal_vulkan_renderstage*)renderstage->internal_data;
+    vulkan_bound_state* bound = &command_buffer->bound;
+
+    // Dynamic offsets are given in binding order.
+    box_descriptor_desc* descriptor = NULL;
+    u32 dynamic_index = 0;
+    for (u32 i = 0; i < darray_length(renderstage->descriptors); ++i) {
+        box_descriptor_desc* candidate = &renderstage->descriptors[i];
+        if (candidate->descriptor_type != BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) continue;
+
+        if (candidate->binding == payload->bind_uniform.binding) descriptor = candidate;
+        else if (candidate->binding < payload->bind_uniform.binding) dynamic_index++;
+    }
+
+    BX_ASSERT(descriptor != NULL && "Malformed data when binding uniform data");
+
+    u64 offset = vulkan_uniform_ring_push(context, RENDERCMD_UNIFORM_DATA(payload), payload->bind_uniform.size, descriptor->uniform_size);
+    if (offset == UINT64_MAX) return;
+
+    VkPipelineBindPoint bind_point = renderstage->pipeline_type == RENDERER_MODE_COMPUTE ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+    VkDescriptorSet descriptor_set = internal_renderstage->descriptor_sets[context->current_frame];
+    bound->dynamic_offsets[dynamic_index] = (u32)offset;
+    bound->descriptor_set = descriptor_set;
+
+    vkCmdBindDescriptorSets(
+        command_buffer->handle, bind_point, internal_renderstage->layout, 0, 1, &descriptor_set,
+        internal_renderstage->dynamic_uniform_count, bound->dynamic_offsets);
+}
+
 void vulkan_renderstage_destroy(
     box_renderer_backend* backend, 
     box_renderstage* renderstage) {
@@ -464,6 +738,11 @@ void vulkan_renderstage_destroy(
         if (internal_renderstage->handle)
             vkDestroyPipeline(context->device.logical_device, internal_renderstage->handle, context->allocator);
 
-        bfree(renderstage->internal_data, sizeof(internal_vulkan_renderstage), MEMORY_TAG_RENDERER);
+        pool_allocator_free(&context->renderstage_pool, renderstage->internal_data);
     }
+
+    if (renderstage->descriptors) darray_destroy(renderstage->descriptors);
+    if (renderstage->push_constants) darray_destroy(renderstage->push_constants);
+    renderstage->descriptors = NULL;
+    renderstage->push_constants = NULL;
 }
\ No newline at end of file
@@ -20,10 +20,38 @@ b8 vulkan_renderstage_update_descriptors(
     box_update_descriptors* descriptors, 
     u32 descriptor_count);
 
+// Gets the latest generation of the renderstage and the buffers it binds, which changes whenever one of them does.
+u64 vulkan_renderstage_generation(
+    box_renderstage* renderstage);
+
+// Binds the pipeline, descriptor set and buffers of the renderstage, skipping whatever the command buffer already has bound.
+// Issued and skipped binds are counted in 'rendercmd_context' when it is not NULL.
 void vulkan_renderstage_bind(
 	vulkan_context* context,
     vulkan_command_buffer* command_buffer,
-	box_renderstage* renderstage);
+	box_renderstage* renderstage,
+    box_rendercmd_context* rendercmd_context);
+
+// Binds the buffers of a bind buffers command, or those of the renderstage where the command has none.
+void vulkan_renderstage_bind_buffers(
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload,
+    box_rendercmd_context* rendercmd_context);
+
+// Records a push constants command for the renderstage, which must be bound on the command buffer.
+void vulkan_renderstage_push_constants(
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload);
+
+// Copies the uniform data of a bind uniform command into the uniform ring and rebinds the descriptor set
+// of the renderstage, which must be bound on the command buffer, with the new dynamic offset.
+void vulkan_renderstage_bind_uniform(
+    vulkan_context* context,
+    vulkan_command_buffer* command_buffer,
+    box_renderstage* renderstage,
+    rendercmd_payload* payload);
 
 void vulkan_renderstage_destroy(
 	box_renderer_backend* backend,
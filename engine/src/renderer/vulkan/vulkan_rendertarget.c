@@ -91,6 +91,7 @@ VkResult vulkan_rendertarget_create_internal(
     // Allocate internal data.
     out_rendertarget->internal_data = ballocate(sizeof(internal_vulkan_rendertarget), MEMORY_TAG_RENDERER);
     internal_vulkan_rendertarget* internal_rendertarget = (internal_vulkan_rendertarget*)out_rendertarget->internal_data;
+    internal_rendertarget->generation = ++context->resource_generation;
 
     internal_rendertarget->attachments = ballocate(sizeof(vulkan_image) * out_rendertarget->attachment_count * context->config.frames_in_flight, MEMORY_TAG_RENDERER);
 
@@ -219,13 +220,11 @@ VkResult vulkan_rendertarget_create_internal(
     return VK_SUCCESS;
 }
 
-void vulkan_rendertarget_begin(
+void vulkan_rendertarget_set_area(
     vulkan_context* context,
     vulkan_command_buffer* command_buffer, 
     box_rendertarget* rendertarget,
     b8 set_viewport, b8 set_scissor) {
-    internal_vulkan_rendertarget* internal_rendertarget = (internal_vulkan_rendertarget*)rendertarget->internal_data;
-
     if (set_viewport) {
 		VkViewport viewport = {};
         viewport.x = (f32)rendertarget->origin.x;
@@ -245,6 +244,16 @@ void vulkan_rendertarget_begin(
         scissor.extent.height = rendertarget->size.height;
 		vkCmdSetScissor(command_buffer->handle, 0, 1, &scissor);
     }
+}
+
+void vulkan_rendertarget_begin(
+    vulkan_context* context,
+    vulkan_command_buffer* command_buffer, 
+    box_rendertarget* rendertarget,
+    b8 set_viewport, b8 set_scissor,
+    b8 secondary_contents) {
+    internal_vulkan_rendertarget* internal_rendertarget = (internal_vulkan_rendertarget*)rendertarget->internal_data;
+    vulkan_rendertarget_set_area(context, command_buffer, rendertarget, set_viewport, set_scissor);
 
     VkRenderPassBeginInfo begin_info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
     begin_info.renderPass = internal_rendertarget->handle;
@@ -263,7 +272,10 @@ void vulkan_rendertarget_begin(
     begin_info.clearValueCount = 1;
     begin_info.pClearValues = &clear_value;
 
-    vkCmdBeginRenderPass(command_buffer->handle, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(
+        command_buffer->handle, 
+        &begin_info, 
+        secondary_contents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 }
 
 void vulkan_rendertarget_end(
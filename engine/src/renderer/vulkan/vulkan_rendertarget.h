@@ -17,12 +17,21 @@ VkResult vulkan_rendertarget_create_internal(
     vulkan_rendertarget_attachment* attachments,
     box_rendertarget* out_rendertarget);
 
-void vulkan_rendertarget_begin(
+// Sets the viewport and/or scissor to the render area of the rendertarget.
+void vulkan_rendertarget_set_area(
     vulkan_context* context,
     vulkan_command_buffer* command_buffer,
     box_rendertarget* rendertarget,
     b8 set_viewport, b8 set_scissor);
 
+// Begins the render pass of the rendertarget, either recording commands inline or executing secondary command buffers.
+void vulkan_rendertarget_begin(
+    vulkan_context* context,
+    vulkan_command_buffer* command_buffer,
+    box_rendertarget* rendertarget,
+    b8 set_viewport, b8 set_scissor,
+    b8 secondary_contents);
+
 void vulkan_rendertarget_end(
     vulkan_context* context,
     vulkan_command_buffer* command_buffer, 
@@ -24,7 +24,7 @@ b8 vulkan_texture_create(
     BX_ASSERT(backend != NULL && out_texture != NULL && "Invalid arguments passed to vulkan_texture_create");
     vulkan_context* context = (vulkan_context*)backend->internal_context;
 
-    out_texture->internal_data = ballocate(sizeof(internal_vulkan_texture), MEMORY_TAG_RENDERER);
+    out_texture->internal_data = pool_allocator_allocate(&context->texture_pool);
     internal_vulkan_texture* internal_texture = (internal_vulkan_texture*)out_texture->internal_data;
 
     out_texture->image_format = config->image_format;
@@ -177,6 +177,6 @@ void vulkan_texture_destroy(
 
         vulkan_image_destroy(context, &internal_texture->image, TRUE);
 
-        bfree(internal_texture, sizeof(internal_vulkan_texture), MEMORY_TAG_RENDERER);
+        pool_allocator_free(&context->texture_pool, internal_texture);
     }
 }
\ No newline at end of file
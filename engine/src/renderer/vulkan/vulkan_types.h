@@ -2,8 +2,12 @@
 
 #include "defines.h"
 
+#include "core/allocators.h"
+
 #include "renderer/renderer_backend.h"
 
+#include "utils/range_allocator.h"
+
 #include "platform/vulkan_platform.h"
 
 // Checks the given Vulkan expression for success and fatally aborts on failure.
@@ -36,11 +40,38 @@ typedef enum vulkan_queue_type {
     VULKAN_QUEUE_TYPE_MAX,
 } vulkan_queue_type;
 
+// A single VkDeviceMemory allocation that resources are suballocated from.
+// Linear (buffer) and optimal (image) resources never share a block, so bufferImageGranularity can be ignored.
+typedef struct vulkan_memory_block {
+    VkDeviceMemory handle;
+    u64 size;
+    u32 memory_type;
+    b8 linear;
+
+    // Blocks made for a single large resource, released as soon as it is freed.
+    b8 dedicated;
+
+    // Persistent mapping of the whole block, NULL unless the memory is host visible.
+    void* mapped;
+    range_allocator ranges;
+} vulkan_memory_block;
+
+// A range of device memory owned by a single resource.
+typedef struct vulkan_allocation {
+    VkDeviceMemory memory;
+    u64 offset, size;
+
+    // Host pointer to the start of the range, NULL unless the memory is host visible.
+    void* mapped;
+    vulkan_memory_block* block;
+    range_allocation range;
+} vulkan_allocation;
+
 // Represents a low level Vulkan image without a VkSampler.
 typedef struct vulkan_image {
     VkImage handle;
     VkImageLayout layout;
-    VkDeviceMemory memory;
+    vulkan_allocation allocation;
     VkImageView view;
 } vulkan_image;
 
@@ -52,12 +83,83 @@ typedef struct vulkan_queue {
     i32 family_index;
 } vulkan_queue;
 
+// Dynamic uniform buffers a single renderstage may declare, the least every device supports.
+#define VULKAN_MAX_DYNAMIC_UNIFORMS 8
+
+// State bound on a command buffer since it began, so binding the same state again can be skipped.
+typedef struct vulkan_bound_state {
+    VkPipeline pipeline;
+    VkPipelineLayout layout;
+    VkDescriptorSet descriptor_set;
+    VkBuffer vertex_buffers[BOX_MAX_VERTEX_BINDINGS];
+    VkBuffer index_buffer;
+    VkDeviceSize vertex_offsets[BOX_MAX_VERTEX_BINDINGS];
+    VkDeviceSize index_offset;
+
+    // Offsets the descriptor set was bound with, one per dynamic uniform buffer in binding order.
+    u32 dynamic_offsets[VULKAN_MAX_DYNAMIC_UNIFORMS];
+} vulkan_bound_state;
+
 // Represents a Vulkan command buffer and its current usage state.
 typedef struct vulkan_command_buffer {
     VkCommandBuffer handle;
     vulkan_queue* owner;
+    vulkan_bound_state bound;
 } vulkan_command_buffer;
 
+// Secondary command buffer holding the translation of a secondary box_rendercmd.
+typedef struct vulkan_secondary_command_buffer {
+    vulkan_command_buffer command_buffer;
+
+    // Command buffer and frame of the last translation, anything else is stale.
+    box_rendercmd* source;
+    u64 frame_number;
+
+    // darray of renderstages begun in the command buffer, matched against pending memory barriers on execution.
+    box_renderstage** renderstages;
+} vulkan_secondary_command_buffer;
+
+// Translation of a static bundle for a single frame in flight, along with the state it was recorded against.
+typedef struct vulkan_static_bundle_frame {
+    vulkan_secondary_command_buffer secondary;
+    b8 recorded;
+
+    u64 content_hash;
+    u64 rendertarget_generation;
+    uvec2 origin, size;
+
+    // darray with the generation of each renderstage in secondary.renderstages at the time of recording.
+    u64* renderstage_generations;
+
+    // darrays of the renderbuffers read by indirect draws or bound by buffer binds and their generation at the time of recording.
+    box_renderbuffer** renderbuffers;
+    u64* renderbuffer_generations;
+
+    // True if the bundle binds uniform data, which lives in the uniform ring for a single frame only.
+    b8 binds_uniforms;
+} vulkan_static_bundle_frame;
+
+// Backend translation of a static box_rendercmd, reused across frames until its commands or resources change.
+typedef struct vulkan_static_bundle {
+    box_rendercmd* source;
+
+    // Frame number the bundle was last executed in, it is recycled once no frame in flight uses it anymore.
+    u64 last_used_frame;
+
+    // darray with a translation per frame in flight, as a command buffer can not be recorded while the GPU uses it.
+    vulkan_static_bundle_frame* frames;
+} vulkan_static_bundle;
+
+// Command pool of a single recording thread for a single frame in flight.
+typedef struct vulkan_recording_thread {
+    // Copy of the graphics queue with a pool of its own, as command pools must only be used by one thread at a time.
+    vulkan_queue queue;
+
+    // darray of secondary command buffers allocated from the pool, reused every time the frame comes around.
+    vulkan_secondary_command_buffer** command_buffers;
+    u32 used_count;
+} vulkan_recording_thread;
+
 // Low level configuration for a attachment to a Vulkan-based rendertarget.
 typedef struct vulkan_rendertarget_attachment {
     box_attachment_type type;
@@ -76,6 +178,10 @@ typedef struct vulkan_device {
     VkPhysicalDevice physical_device;
     VkDevice logical_device;
     vulkan_queue mode_queues[VULKAN_QUEUE_TYPE_MAX];
+
+    // Indirect draw features enabled on the logical device.
+    b8 multi_draw_indirect;
+    b8 draw_indirect_count;
 } vulkan_device;
 
 // Represents a connection to a platform surface with swapcahin and synchronization primitives.
@@ -98,10 +204,13 @@ typedef struct vulkan_window_system {
 // Internal Vulkan implementation of a box_renderbuffer.
 typedef struct internal_vulkan_renderbuffer {
     VkBuffer handle;
-    VkDeviceMemory memory;
+    vulkan_allocation allocation;
     VkBufferUsageFlags usage;
     VkMemoryPropertyFlags properties;
     VkMemoryRequirements memory_requirements;
+
+    // Unique within the context, static bundles using the buffer are recorded again once it changes.
+    u64 generation;
 } internal_vulkan_renderbuffer;
 
 // Internal Vulkan implementation of a box_renderstage.
@@ -112,11 +221,21 @@ typedef struct internal_vulkan_renderstage {
     VkDescriptorSet* descriptor_sets;
     VkDescriptorSetLayout descriptor;
 
+    // Number of dynamic uniform buffers, each needing an offset whenever the descriptor set is bound.
+    u32 dynamic_uniform_count;
+
     union {
         struct {
-            box_renderbuffer* vertex_buffer, * index_buffer;
+            // Buffers bound with the renderstage, one per vertex binding.
+            box_renderbuffer* vertex_buffers[BOX_MAX_VERTEX_BINDINGS];
+            u32 vertex_binding_count;
+
+            box_renderbuffer* index_buffer;
         } graphics;
     };
+
+    // Unique within the context, renewed whenever the descriptor sets are updated.
+    u64 generation;
 } internal_vulkan_renderstage;
 
 // Internal Vulkan implementation of a box_texture.
@@ -130,8 +249,25 @@ typedef struct internal_vulkan_rendertarget {
     VkRenderPass handle;
     vulkan_image* attachments;
     VkFramebuffer* framebuffers;
+
+    // Unique within the context, static bundles drawing into the rendertarget are recorded again once it changes.
+    u64 generation;
 } internal_vulkan_rendertarget;
 
+// Persistently mapped buffer holding the data of dynamic uniform buffers, one region per frame in flight.
+typedef struct vulkan_uniform_ring {
+    box_renderbuffer buffer;
+
+    // Size in bytes of the region of each frame, a multiple of the alignment.
+    u64 frame_size;
+
+    // Alignment of every allocation, as required for dynamic offsets.
+    u64 alignment;
+
+    // Bytes handed out from the region of the current frame, advanced atomically by recording threads.
+    volatile u64 head;
+} vulkan_uniform_ring;
+
 // Represents a relationship in resource memory between renderstages.
 typedef struct memory_barrier {
     u64 created_on_submission;
@@ -145,7 +281,11 @@ typedef struct memory_barrier {
 typedef struct vulkan_queue_submission {
     vulkan_command_buffer* command_buffer;
     VkSemaphore signal_semaphore;
+
+    // Allocated from the frame allocator of the frame this submission was recorded on.
     VkSemaphore* wait_semaphores;
+    VkPipelineStageFlags* wait_stages;
+    u32 wait_semaphore_count;
 } vulkan_queue_submission;
 
 // Represents the global Vulkan backend context.
@@ -158,18 +298,50 @@ typedef struct vulkan_context {
     VkAllocationCallbacks* allocator;
     VkDebugUtilsMessengerEXT debug_messenger;
     vulkan_device device;
+
+    pool_allocator renderbuffer_pool;
+    pool_allocator texture_pool;
+    pool_allocator renderstage_pool;
+
+    // darray of every device memory block, see vulkan_memory.h.
+    vulkan_memory_block** memory_blocks;
     
     vulkan_command_buffer* graphics_command_ring;
     vulkan_command_buffer* compute_command_ring;
 
+    // frames_in_flight * recording_thread_count secondary command pools, grouped by frame.
+    vulkan_recording_thread* recording_threads;
+    u32 recording_thread_count;
+
+    // Number of frames ended since initialization.
+    u64 frame_number;
+
+    // Last generation handed out to a renderstage, renderbuffer or rendertarget.
+    u64 resource_generation;
+
+    // Copy of the graphics queue with a pool of its own, holding the command buffers of static bundles.
+    vulkan_queue static_bundle_queue;
+
+    // darray of every static bundle translated so far, recycled instead of freed.
+    vulkan_static_bundle** static_bundles;
+
+    // Holds the data of dynamic uniform buffers, reset when the frame using a region begins again.
+    vulkan_uniform_ring uniform_ring;
+
     VkSemaphore* queue_complete_semaphores;
     VkFence* in_flight_fences;
+    frame_allocator* frame_allocators;
 
     VkSemaphore* semaphore_pool;
     u32 semaphore_next_index;
     memory_barrier* memory_barriers;
     vulkan_queue_submission* queued_submissions;
     box_renderer_mode last_mode;
+
+#if BOX_ENABLE_DIAGNOSTICS
+    // Allocations made by the backend's frame functions since the frame began, on any thread.
+    volatile u64 frame_path_allocations;
+#endif
 } vulkan_context;
 
 // Finds a compatible memory type index on the physical device.
@@ -190,6 +362,9 @@ VkSamplerAddressMode box_address_mode_to_vulkan_type(box_address_mode address);
 // Converts engine render format to a Vulkan format.
 VkFormat box_render_format_to_vulkan_type(box_render_format format);
 
+// Converts engine index type to a Vulkan index type.
+VkIndexType box_index_type_to_vulkan_type(box_index_type type);
+
 // Converts engine load op format to a Vulkan format.
 VkAttachmentLoadOp box_load_op_to_vulkan_type(box_load_op load_op);
 
@@ -32,6 +32,7 @@ VkDescriptorType box_descriptor_type_to_vulkan_type(box_descriptor_type descript
     case BOX_DESCRIPTOR_TYPE_STORAGE_BUFFER: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     case BOX_DESCRIPTOR_TYPE_STORAGE_IMAGE:  return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
     case BOX_DESCRIPTOR_TYPE_IMAGE_SAMPLER:  return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case BOX_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     
     default:
         BX_ASSERT(FALSE && "Unsupported descriptor type!");
@@ -64,6 +65,18 @@ VkSamplerAddressMode box_address_mode_to_vulkan_type(box_address_mode address) {
     }
 }
 
+VkIndexType box_index_type_to_vulkan_type(box_index_type type) {
+    switch (type) {
+    case BOX_INDEX_TYPE_UINT16: return VK_INDEX_TYPE_UINT16;
+    case BOX_INDEX_TYPE_UINT32: return VK_INDEX_TYPE_UINT32;
+    case BOX_INDEX_TYPE_UINT8:  return VK_INDEX_TYPE_UINT8_EXT;
+
+    default:
+        BX_ASSERT(FALSE && "Unsupported index type!");
+        return 0;
+    }
+}
+
 VkFormat box_render_format_to_vulkan_type(box_render_format format) {
     switch (format) {
         /* 8-bit integer  */
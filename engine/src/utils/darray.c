@@ -1,29 +1,152 @@
 #include "defines.h"
 #include "darray.h"
 
-void* _darray_create(u64 length, u64 stride, void* init_data, memory_tag tag) {
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+#include "platform/platform.h"
+
+// Bytes reserved in front of the elements, padded so the elements keep the requested alignment.
+u64 darray_header_size(u64 element_alignment) {
+    return alignment(DARRAY_FIELD_LENGTH * sizeof(u64), BX_MAX(element_alignment, 16ULL));
+}
+
+void* _darray_create(u64 length, u64 stride, u64 alignment, void* init_data, memory_tag tag) {
+    BX_ASSERT((alignment & (alignment - 1)) == 0 && "Invalid arguments passed to _darray_create");
+
+    u64 header_size = darray_header_size(alignment);
     u64 array_size = length * stride;
-    u64* new_array = ballocate(header_size + array_size, tag);
+    u8* block = alignment > 0 ? 
+        ballocate_aligned(header_size + array_size, alignment, tag) : 
+        ballocate(header_size + array_size, tag);
+
+    u64* new_array = (u64*)(block + header_size) - DARRAY_FIELD_LENGTH;
     new_array[DARRAY_CAPACITY] = length;
     new_array[DARRAY_LENGTH] = (init_data != NULL ? length : 0);
     new_array[DARRAY_STRIDE] = stride;
     new_array[DARRAY_MEMORY_TAG] = tag;
+    new_array[DARRAY_ALIGNMENT] = alignment;
+    new_array[DARRAY_RESERVED] = 0;
+    new_array[DARRAY_INLINE] = 0;
 
-    void* temp = bzero_memory((void*)(new_array + DARRAY_FIELD_LENGTH), array_size);
+    void* temp = bzero_memory(block + header_size, array_size);
     if (init_data) {
         bcopy_memory(temp, init_data, length * stride);
     }
     return temp;
 }
 
+// Bytes of a virtual darray's reservation that are committed to hold 'capacity' elements.
+u64 darray_virtual_committed_size(u64 capacity, u64 stride) {
+    return alignment(darray_header_size(0) + capacity * stride, platform_get_page_size());
+}
+
+// Commits enough pages to hold 'capacity' elements and returns the capacity that fits in them.
+u64 darray_virtual_commit(u8* block, u64 capacity, u64 stride, u64 max_capacity) {
+    u64 committed = darray_virtual_committed_size(capacity, stride);
+    if (!platform_commit_memory(block, committed)) return 0;
+
+    // Use the slack at the end of the last page as well.
+    return BX_MIN((committed - darray_header_size(0)) / stride, max_capacity);
+}
+
+void* _darray_create_virtual(u64 max_capacity, u64 stride, memory_tag tag) {
+    BX_ASSERT(max_capacity > 0 && stride > 0 && "Invalid arguments passed to _darray_create_virtual");
+
+    u64 header_size = darray_header_size(0);
+    u64 reserved_size = darray_virtual_committed_size(max_capacity, stride);
+    u8* block = platform_reserve_memory(reserved_size);
+    if (!block) {
+        BX_ERROR("Failed to reserve %llu bytes for virtual darray", reserved_size);
+        return NULL;
+    }
+
+    u64 capacity = darray_virtual_commit(block, DARRAY_DEFAULT_CAPACITY, stride, max_capacity);
+    if (capacity == 0) {
+        BX_ERROR("Failed to commit memory for virtual darray");
+        platform_release_memory(block, reserved_size);
+        return NULL;
+    }
+
+    // Only committed pages count towards the tag.
+    breport(darray_virtual_committed_size(capacity, stride), tag);
+
+    u64* new_array = (u64*)(block + header_size) - DARRAY_FIELD_LENGTH;
+    new_array[DARRAY_CAPACITY] = capacity;
+    new_array[DARRAY_LENGTH] = 0;
+    new_array[DARRAY_STRIDE] = stride;
+    new_array[DARRAY_MEMORY_TAG] = tag;
+    new_array[DARRAY_ALIGNMENT] = 0;
+    new_array[DARRAY_RESERVED] = max_capacity;
+    new_array[DARRAY_INLINE] = 0;
+    return block + header_size;
+}
+
+void* _darray_create_inline(void* storage, u64 storage_size, u64 stride, memory_tag tag) {
+    BX_ASSERT(storage != NULL && stride > 0 && "Invalid arguments passed to _darray_create_inline");
+    BX_ASSERT(storage_size >= DARRAY_DEFAULT_HEADER_SIZE + stride && "Inline darray storage can not hold a single element");
+
+    u64 header_size = darray_header_size(0);
+    u8* block = bzero_memory(storage, storage_size);
+
+    u64* new_array = (u64*)(block + header_size) - DARRAY_FIELD_LENGTH;
+    new_array[DARRAY_CAPACITY] = (storage_size - header_size) / stride;
+    new_array[DARRAY_LENGTH] = 0;
+    new_array[DARRAY_STRIDE] = stride;
+    new_array[DARRAY_MEMORY_TAG] = tag;
+    new_array[DARRAY_ALIGNMENT] = 0;
+    new_array[DARRAY_RESERVED] = 0;
+    new_array[DARRAY_INLINE] = 1;
+    return block + header_size;
+}
+
+// Grows a virtual darray in place by committing more of its reservation.
+// Returns NULL and leaves the darray untouched when the reservation can not hold 'min_capacity' elements.
+void* darray_virtual_grow(void* array, u64 min_capacity) {
+    u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
+    u64 capacity = header[DARRAY_CAPACITY];
+    u64 stride = header[DARRAY_STRIDE];
+    u64 max_capacity = header[DARRAY_RESERVED];
+    
+    if (min_capacity > max_capacity) {
+        BX_ERROR("Virtual darray is full! Reserved capacity: %llu", max_capacity);
+        return NULL;
+    }
+
+    u8* block = (u8*)array - darray_header_size(0);
+    u64 new_capacity = darray_virtual_commit(block, BX_MIN(BX_MAX(capacity * DARRAY_RESIZE_FACTOR, min_capacity), max_capacity), stride, max_capacity);
+    if (new_capacity == 0) {
+        BX_ERROR("Failed to commit memory for virtual darray");
+        return NULL;
+    }
+
+    breport(darray_virtual_committed_size(new_capacity, stride) - darray_virtual_committed_size(capacity, stride), header[DARRAY_MEMORY_TAG]);
+    header[DARRAY_CAPACITY] = new_capacity;
+    return array;
+}
+
 void _darray_destroy(void* array) {
     BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_destroy");
 
     u64* header = (u64*)array - DARRAY_FIELD_LENGTH;
-    u64 header_size = DARRAY_FIELD_LENGTH * sizeof(u64);
+
+    // The caller owns inline storage, once the darray spilled to the heap this flag is cleared.
+    if (header[DARRAY_INLINE]) return;
+
+    if (header[DARRAY_RESERVED] > 0) {
+        u64 committed = darray_virtual_committed_size(header[DARRAY_CAPACITY], header[DARRAY_STRIDE]);
+        breport_free(committed, header[DARRAY_MEMORY_TAG]);
+        platform_release_memory(
+            (u8*)array - darray_header_size(0), 
+            darray_virtual_committed_size(header[DARRAY_RESERVED], header[DARRAY_STRIDE]));
+        return;
+    }
+
+    u64 header_size = darray_header_size(header[DARRAY_ALIGNMENT]);
     u64 total_size = header_size + header[DARRAY_CAPACITY] * header[DARRAY_STRIDE];
-    bfree(header, total_size, _darray_field_get(array, DARRAY_MEMORY_TAG));
+    u8* block = (u8*)array - header_size;
+
+    if (header[DARRAY_ALIGNMENT] > 0)
+        bfree_aligned(block, total_size, header[DARRAY_MEMORY_TAG]);
+    else
+        bfree(block, total_size, header[DARRAY_MEMORY_TAG]);
 }
 
 u64 _darray_field_get(void* array, u64 field) {
@@ -41,21 +164,57 @@ void _darray_field_set(void* array, u64 field, u64 value) {
     header[field] = value;
 }
 
-void* _darray_resize(void* array) {
-    BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_resize");
-
+// Moves the elements into a new block holding 'capacity' elements.
+void* darray_resize_to(void* array, u64 capacity) {
     u64 length = darray_length(array);
     u64 stride = darray_stride(array);
     void* temp = _darray_create(
-        (DARRAY_RESIZE_FACTOR * (darray_capacity(array) == 0 ? DARRAY_DEFAULT_CAPACITY : darray_capacity(array))),
-        stride, array, 
+        capacity, stride, _darray_field_get(array, DARRAY_ALIGNMENT), NULL, 
         _darray_field_get(array, DARRAY_MEMORY_TAG));
 
-    _darray_field_set(temp, DARRAY_LENGTH, length);
+    // Only the live elements are copied, the old array may be larger or smaller than the new one.
+    bcopy_memory(temp, array, BX_MIN(length, capacity) * stride);
+    _darray_field_set(temp, DARRAY_LENGTH, BX_MIN(length, capacity));
     _darray_destroy(array);
     return temp;
 }
 
+void* _darray_resize(void* array) {
+    BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_resize");
+
+    u64 capacity = darray_capacity(array);
+    if (_darray_field_get(array, DARRAY_RESERVED) > 0) 
+        return darray_virtual_grow(array, capacity + 1);
+
+    return darray_resize_to(array, DARRAY_RESIZE_FACTOR * (capacity == 0 ? DARRAY_DEFAULT_CAPACITY : capacity));
+}
+
+void* _darray_reserve_more(void* array, u64 count) {
+    BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_reserve_more");
+
+    u64 required = darray_length(array) + count;
+    u64 capacity = darray_capacity(array);
+    if (required <= capacity) return array;
+
+    if (_darray_field_get(array, DARRAY_RESERVED) > 0) 
+        return darray_virtual_grow(array, required);
+
+    // Grow geometrically so repeated small reservations stay amortized O(1).
+    return darray_resize_to(array, BX_MAX(required, DARRAY_RESIZE_FACTOR * capacity));
+}
+
+void* _darray_shrink_to_fit(void* array) {
+    BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_shrink_to_fit");
+
+    // Virtual darrays keep their committed pages, their elements must never move.
+    // Inline darrays would only trade free stack space for a heap allocation.
+    u64 length = BX_MAX(darray_length(array), (u64)DARRAY_DEFAULT_CAPACITY);
+    if (_darray_field_get(array, DARRAY_RESERVED) > 0 || _darray_field_get(array, DARRAY_INLINE) || length == darray_capacity(array)) 
+        return array;
+
+    return darray_resize_to(array, length);
+}
+
 void* _darray_push(void* array, const void* value_ptr) {
     BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_push");
 
@@ -63,6 +222,7 @@ void* _darray_push(void* array, const void* value_ptr) {
     u64 stride = darray_stride(array);
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (!array) return NULL;
     }
     
     if (value_ptr != NULL) {
@@ -74,13 +234,38 @@ void* _darray_push(void* array, const void* value_ptr) {
     return array;
 }
 
+void* _darray_push_n(void* array, const void* values, u64 count) {
+    BX_ASSERT(array != NULL && "Invalid arguments passed to _darray_push_n");
+
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    array = _darray_reserve_more(array, count);
+    if (!array) return NULL;
+
+    void* dest = (u8*)array + length * stride;
+    if (values) 
+        bcopy_memory(dest, values, count * stride);
+    else 
+        bzero_memory(dest, count * stride);
+
+    _darray_field_set(array, DARRAY_LENGTH, length + count);
+    return array;
+}
+
+void* _darray_append_array(void* array, const void* other) {
+    BX_ASSERT(array != NULL && other != NULL && darray_stride(array) == darray_stride(other) && "Invalid arguments passed to _darray_append_array");
+    return _darray_push_n(array, other, darray_length(other));
+}
+
 void* _darray_push_empty(void** out_array) {
     BX_ASSERT(out_array != NULL && "Invalid arguments passed to _darray_push_empty");
 
     u64 length = darray_length(*out_array);
     u64 stride = darray_stride(*out_array);
     if (length >= darray_capacity(*out_array)) {
-        *out_array = _darray_resize(*out_array);
+        void* grown = _darray_resize(*out_array);
+        if (!grown) return NULL;
+        *out_array = grown;
     }
     
     _darray_field_set(*out_array, DARRAY_LENGTH, length + 1);
@@ -111,12 +296,12 @@ void* _darray_pop_at(void* array, u64 index, void* dest) {
     u64 addr = (u64)array;
     if (dest) bcopy_memory(dest, (void*)(addr + (index * stride)), stride);
 
-    // If not on the last element, snip out the entry and copy the rest inward.
+    // If not on the last element, snip out the entry and move the rest inward.
     if (index != length - 1) {
-        bcopy_memory(
+        bmove_memory(
             (void*)(addr + (index * stride)),
             (void*)(addr + ((index + 1) * stride)),
-            stride * (length - index));
+            stride * (length - index - 1));
     }
 
     _darray_field_set(array, DARRAY_LENGTH, length - 1);
@@ -134,21 +319,46 @@ void* _darray_insert_at(void* array, u64 index, void* value_ptr) {
     }
     if (length >= darray_capacity(array)) {
         array = _darray_resize(array);
+        if (!array) return NULL;
     }
 
     u64 addr = (u64)array;
 
-    // If not on the last element, copy the rest outward.
-    if (index != length - 1) {
-        bcopy_memory(
-            (void*)(addr + ((index + 1) * stride)),
-            (void*)(addr + (index * stride)),
-            stride * (length - index));
-    }
+    // Move the rest outward, including the last element.
+    bmove_memory(
+        (void*)(addr + ((index + 1) * stride)),
+        (void*)(addr + (index * stride)),
+        stride * (length - index));
 
     // Set the value at the index
     bcopy_memory((void*)(addr + (index * stride)), value_ptr, stride);
 
     _darray_field_set(array, DARRAY_LENGTH, length + 1);
     return array;
-}
\ No newline at end of file
+}
+
+void _darray_swap_remove(void* array, u64 index, void* dest) {
+    BX_ASSERT(array != NULL && index < darray_length(array) && "Invalid arguments passed to _darray_swap_remove");
+
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    u8* element = (u8*)array + index * stride;
+    if (dest) bcopy_memory(dest, element, stride);
+
+    // Fill the hole with the last element instead of shifting the tail.
+    if (index != length - 1)
+        bcopy_memory(element, (u8*)array + (length - 1) * stride, stride);
+
+    _darray_field_set(array, DARRAY_LENGTH, length - 1);
+}
+
+void _darray_erase_range(void* array, u64 index, u64 count) {
+    BX_ASSERT(array != NULL && index + count <= darray_length(array) && "Invalid arguments passed to _darray_erase_range");
+
+    u64 length = darray_length(array);
+    u64 stride = darray_stride(array);
+    u8* addr = (u8*)array;
+
+    bmove_memory(addr + index * stride, addr + (index + count) * stride, (length - index - count) * stride);
+    _darray_field_set(array, DARRAY_LENGTH, length - count);
+}
@@ -8,7 +8,18 @@ u64 capacity = number elements that can be held
 u64 length = number of elements currently contained
 u64 stride = size of each element in bytes
 u64 memory_tag = memory tag of darray
+u64 alignment = alignment of elements in bytes, 0 if default
+u64 reserved = maximum capacity of a virtual darray, 0 for heap darrays
+u64 inline = 1 while the darray lives in caller provided storage
 void* elements
+
+The header is padded at the front so elements start on their alignment boundary.
+
+Virtual darrays reserve address space for 'reserved' elements up front and commit pages
+as they grow, so growing never moves the elements and pointers into the array stay valid.
+
+Inline darrays keep their header and first elements in storage provided by the caller
+(usually the stack) and only move to the heap once they outgrow it.
 */
 
 enum {
@@ -16,70 +27,182 @@ enum {
     DARRAY_LENGTH,
     DARRAY_STRIDE,
     DARRAY_MEMORY_TAG,
+    DARRAY_ALIGNMENT,
+    DARRAY_RESERVED,
+    DARRAY_INLINE,
     DARRAY_FIELD_LENGTH
 };
 
-void* _darray_create(u64 length, u64 stride, void* init_data, memory_tag tag);
+// Bytes in front of the elements of darrays with default alignment.
+#define DARRAY_DEFAULT_HEADER_SIZE (((DARRAY_FIELD_LENGTH * 8) + 15) & ~15)
+
+// Declares storage named 'name' for an inline darray of up to 'capacity' elements of 'type'.
+#define DARRAY_INLINE_STORAGE(name, type, capacity) \
+    u64 name[(DARRAY_DEFAULT_HEADER_SIZE + sizeof(type) * (capacity) + 7) / 8]
+
+void* _darray_create(u64 length, u64 stride, u64 alignment, void* init_data, memory_tag tag);
+void* _darray_create_virtual(u64 max_capacity, u64 stride, memory_tag tag);
+void* _darray_create_inline(void* storage, u64 storage_size, u64 stride, memory_tag tag);
 void _darray_destroy(void* array);
 
 u64 _darray_field_get(void* array, u64 field);
 void _darray_field_set(void* array, u64 field, u64 value);
 
+// Functions growing the darray return NULL and leave it untouched when a virtual darray is full,
+// the macros below then keep the old pointer and the push is dropped.
 void* _darray_resize(void* array);
+void* _darray_reserve_more(void* array, u64 count);
+void* _darray_shrink_to_fit(void* array);
 
 void* _darray_push(void* array, const void* value_ptr);
+void* _darray_push_n(void* array, const void* values, u64 count);
+void* _darray_append_array(void* array, const void* other);
 void* _darray_push_empty(void** array);
 void _darray_pop(void* array, void* dest);
 
 void* _darray_pop_at(void* array, u64 index, void* dest);
 void* _darray_insert_at(void* array, u64 index, void* value_ptr);
 
+void _darray_swap_remove(void* array, u64 index, void* dest);
+void _darray_erase_range(void* array, u64 index, u64 count);
+
+// The header sits directly in front of the elements, so reading a field is a single load.
+static inline u64* darray_header(const void* array) {
+    return (u64*)array - DARRAY_FIELD_LENGTH;
+}
+
+static inline u64 darray_capacity(const void* array) {
+    return darray_header(array)[DARRAY_CAPACITY];
+}
+
+static inline u64 darray_length(const void* array) {
+    return darray_header(array)[DARRAY_LENGTH];
+}
+
+static inline u64 darray_stride(const void* array) {
+    return darray_header(array)[DARRAY_STRIDE];
+}
+
 #define DARRAY_DEFAULT_CAPACITY 1
 #define DARRAY_RESIZE_FACTOR 2
 
 #define darray_create(type, tag) \
-    _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), NULL, tag)
+    _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), 0, NULL, tag)
 
 #define darray_reserve(type, capacity, tag) \
-    _darray_create(capacity, sizeof(type), NULL, tag)
+    _darray_create(capacity, sizeof(type), 0, NULL, tag)
 
 #define darray_from_data(type, length, data_ptr, tag) \
-    _darray_create(length, sizeof(type), data_ptr, tag);
+    _darray_create(length, sizeof(type), 0, data_ptr, tag);
+
+#define darray_create_aligned(type, alignment, tag) \
+    _darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), alignment, NULL, tag)
+
+#define darray_reserve_aligned(type, capacity, alignment, tag) \
+    _darray_create(capacity, sizeof(type), alignment, NULL, tag)
+
+#define darray_create_virtual(type, max_capacity, tag) \
+    _darray_create_virtual(max_capacity, sizeof(type), tag)
+
+#define darray_create_inline(type, storage, tag) \
+    _darray_create_inline(storage, sizeof(storage), sizeof(type), tag)
 
 #define darray_destroy(array) _darray_destroy(array);
 
 #define darray_push(array, value)                        \
     do {                                                 \
         __typeof__(*(array)) _tmp = (value);             \
-        array = _darray_push(array, &_tmp);              \
+        void* _pushed = _darray_push(array, &_tmp);      \
+        if (_pushed) array = _pushed;                    \
     } while(0)
 
+// Returns the new zeroed element, or NULL when a full virtual darray can not grow.
 #define darray_push_empty(array) \
     _darray_push_empty((void**) &array)
 
 #define darray_pop(array, value_ptr) \
     _darray_pop(array, value_ptr)
 
-#define darray_insert_at(array, index, value)           \
-    do {                                                \
-        void* temp = (void*)(value);                    \
-        array = _darray_insert_at(array, index, &temp); \
+#define darray_insert_at(array, index, value)                     \
+    do {                                                          \
+        void* temp = (void*)(value);                              \
+        void* _inserted = _darray_insert_at(array, index, &temp); \
+        if (_inserted) array = _inserted;                         \
     } while(0)
 
 #define darray_pop_at(array, index, value_ptr) \
     _darray_pop_at(array, index, value_ptr)
 
-#define darray_clear(array) \
-    _darray_field_set(array, DARRAY_LENGTH, 0)
+// Appends 'count' elements copied from 'values', or zeroed if 'values' is NULL, growing at most once.
+#define darray_push_n(array, values, count)                  \
+    do {                                                     \
+        void* _pushed = _darray_push_n(array, values, count); \
+        if (_pushed) array = _pushed;                        \
+    } while(0)
+
+// Appends every element of the darray 'other', which must have the same stride.
+#define darray_append_array(array, other)                  \
+    do {                                                   \
+        void* _pushed = _darray_append_array(array, other); \
+        if (_pushed) array = _pushed;                      \
+    } while(0)
 
-#define darray_capacity(array) \
-    _darray_field_get(array, DARRAY_CAPACITY)
+// Removes the element at 'index' in O(1) by moving the last element into its place. Does not keep order.
+#define darray_swap_remove(array, index, value_ptr) \
+    _darray_swap_remove(array, index, value_ptr)
 
-#define darray_length(array) \
-    _darray_field_get(array, DARRAY_LENGTH)
+// Removes 'count' elements starting at 'index', keeping the order of the rest.
+#define darray_erase_range(array, index, count) \
+    _darray_erase_range(array, index, count)
 
-#define darray_stride(array) \
-    _darray_field_get(array, DARRAY_STRIDE)
+// Makes room for at least 'count' more elements without further reallocations.
+#define darray_reserve_more(array, count)                     \
+    do {                                                      \
+        void* _reserved = _darray_reserve_more(array, count); \
+        if (_reserved) array = _reserved;                     \
+    } while(0)
+
+// Releases unused capacity. Virtual and inline darrays are left untouched.
+#define darray_shrink_to_fit(array) \
+    array = _darray_shrink_to_fit(array)
+
+#define darray_clear(array) \
+    _darray_field_set(array, DARRAY_LENGTH, 0)
 
 #define darray_length_set(array, value) \
     _darray_field_set(array, DARRAY_LENGTH, value)
+
+// Generates helpers for a darray of 'type' with the stride known at compile time, so pushing
+// and popping compile down to plain loads and stores. 'type' must be a single identifier.
+// DARRAY_DEFINE(u32) provides darray_u32_create, darray_u32_push, darray_u32_push_empty and darray_u32_pop.
+// When a full virtual darray can not grow, push returns the array unchanged and push_empty returns NULL.
+#define DARRAY_DEFINE(type)                                                                     \
+    static inline type* darray_##type##_create(memory_tag tag) {                                \
+        return (type*)_darray_create(DARRAY_DEFAULT_CAPACITY, sizeof(type), 0, NULL, tag);     \
+    }                                                                                           \
+    static inline type* darray_##type##_push(type* array, type value) {                         \
+        u64 length = darray_header(array)[DARRAY_LENGTH];                                       \
+        if (length >= darray_header(array)[DARRAY_CAPACITY]) {                                  \
+            type* grown = (type*)_darray_resize(array);                                         \
+            if (!grown) return array;                                                           \
+            array = grown;                                                                      \
+        }                                                                                       \
+        array[length] = value;                                                                  \
+        darray_header(array)[DARRAY_LENGTH] = length + 1;                                       \
+        return array;                                                                           \
+    }                                                                                           \
+    static inline type* darray_##type##_push_empty(type** array) {                              \
+        u64 length = darray_header(*array)[DARRAY_LENGTH];                                      \
+        if (length >= darray_header(*array)[DARRAY_CAPACITY]) {                                 \
+            type* grown = (type*)_darray_resize(*array);                                        \
+            if (!grown) return NULL;                                                            \
+            *array = grown;                                                                     \
+        }                                                                                       \
+        darray_header(*array)[DARRAY_LENGTH] = length + 1;                                      \
+        (*array)[length] = (type){ 0 };                                                         \
+        return &(*array)[length];                                                               \
+    }                                                                                           \
+    static inline type darray_##type##_pop(type* array) {                                       \
+        BX_ASSERT(darray_header(array)[DARRAY_LENGTH] > 0 && "Tried to pop an empty darray");  \
+        return array[--darray_header(array)[DARRAY_LENGTH]];                                    \
+    }
@@ -1,30 +1,121 @@
 #include "defines.h"
 #include "freelist.h"
 
+#include "utils/darray.h"
+
 #pragma pack(push, 1)
 typedef struct freelist_header {
     u64 payload_size;
 } freelist_header;
 #pragma pack(pop)
 
-void* get_user_memory(freelist* list, void* internal_block) {
-    BX_ASSERT(list != NULL && internal_block != NULL && "Invalid arguments passed to get_user_memory");
-    return (u8*)internal_block + sizeof(freelist_header);
+// Sits at the start of every chunk of a segmented list. Chunks are aligned to the list's chunk size and
+// blocks only start within the first chunk size bytes, so the chunk of any block is found by masking its address.
+typedef struct freelist_chunk {
+    struct freelist_chunk* next;
+
+    // Bytes used within this chunk, including this header.
+    u64 used;
+
+    // Size of this chunk in bytes, a multiple of the list's chunk size for chunks made for oversized blocks.
+    u64 size;
+} freelist_chunk;
+
+// Allocates the internal memory of the freelist, only using an aligned allocation when the blocks need more than the default alignment.
+void* freelist_allocate_memory(freelist* list, u64 size) {
+    if (list->alignment > 16) return ballocate_aligned(size, list->alignment, list->tag);
+    return ballocate(size, list->tag);
+}
+
+void freelist_free_memory(freelist* list) {
+    if (list->alignment > 16) bfree_aligned(list->memory, list->capacity, list->tag);
+    else bfree(list->memory, list->capacity, list->tag);
+}
+
+// Offset of the next block's payload after a block ending at 'end_offset'.
+u64 freelist_next_payload_offset(freelist* list, u64 end_offset) {
+    return alignment(end_offset + sizeof(freelist_header), list->alignment);
+}
+
+freelist_chunk* freelist_chunk_of(freelist* list, const void* block) {
+    return (freelist_chunk*)((u64)block & ~(list->chunk_size - 1));
+}
+
+// Allocates a chunk of 'size' bytes and links it in right after 'previous', or as the first chunk if that is NULL.
+freelist_chunk* freelist_add_chunk(freelist* list, freelist_chunk* previous, u64 size) {
+    freelist_chunk* chunk = ballocate_aligned(size, list->chunk_size, list->tag);
+    if (!chunk) return NULL;
+
+    chunk->used = sizeof(freelist_chunk);
+    chunk->size = size;
+    list->capacity += size;
+
+    if (previous) {
+        chunk->next = previous->next;
+        previous->next = chunk;
+    }
+    else {
+        chunk->next = list->memory;
+        list->memory = chunk;
+    }
+    return chunk;
+}
+
+void freelist_free_chunks(freelist* list) {
+    freelist_chunk* chunk = list->memory;
+    while (chunk) {
+        freelist_chunk* next = chunk->next;
+        bfree_aligned(chunk, chunk->size, list->tag);
+        chunk = next;
+    }
+
+    list->memory = NULL;
+    list->current_chunk = NULL;
 }
 
 void freelist_create(u64 start_size, memory_tag tag, freelist* out_list) {
-    BX_ASSERT(out_list != NULL && "Invalid arguments passed to freelist_create");
+    freelist_create_aligned(start_size, 8ULL, tag, out_list);
+}
+
+void freelist_create_aligned(u64 start_size, u64 alignment, memory_tag tag, freelist* out_list) {
+    BX_ASSERT(out_list != NULL && alignment >= 8 && (alignment & (alignment - 1)) == 0 && "Invalid arguments passed to freelist_create");
 
     out_list->memory = NULL;
     out_list->size = 0;
     out_list->capacity = 0;
+    out_list->chunk_size = 0;
+    out_list->current_chunk = NULL;
+    out_list->alignment = alignment;
     out_list->tag = tag;
+    out_list->block_offsets = NULL;
 
     if (start_size > 0) {
         freelist_resize(out_list, start_size);
     }
 }
 
+void freelist_create_segmented(u64 chunk_size, memory_tag tag, freelist* out_list) {
+    BX_ASSERT(out_list != NULL && chunk_size > sizeof(freelist_chunk) && (chunk_size & (chunk_size - 1)) == 0 && "Invalid arguments passed to freelist_create_segmented");
+
+    freelist_create_aligned(0, 8ULL, tag, out_list);
+    out_list->chunk_size = chunk_size;
+    out_list->current_chunk = freelist_add_chunk(out_list, NULL, chunk_size);
+}
+
+void freelist_enable_index(freelist* list) {
+    BX_ASSERT(list != NULL && "Invalid arguments passed to freelist_enable_index");
+    if (list->block_offsets) return;
+
+    list->block_offsets = darray_create(u64, list->tag);
+    if (!list->memory) return;
+
+    u8* cursor = 0;
+    while (freelist_next_block(list, &cursor)) {
+        u64 offset = list->chunk_size > 0 ? (u64)cursor : (u64)(cursor - (u8*)list->memory);
+        darray_push(list->block_offsets, offset);
+    }
+}
+
 b8 freelist_empty(freelist* list) {
     return list == NULL || list->capacity == 0;
 }
@@ -32,12 +123,20 @@ b8 freelist_empty(freelist* list) {
 void freelist_destroy(freelist* list) {
     BX_ASSERT(list != NULL && "Invalid arguments passed to freelist_destroy");
 
-    if (list->memory) {
+    if (list->chunk_size > 0) {
+        freelist_free_chunks(list);
+    }
+    else if (list->memory) {
         BX_ASSERT(list->capacity > 0 && "Allocated memory in freelist but not recorded capacity");
-        bfree(list->memory, list->capacity, list->tag);
+        freelist_free_memory(list);
         list->memory = NULL;
     }
 
+    if (list->block_offsets) {
+        darray_destroy(list->block_offsets);
+        list->block_offsets = NULL;
+    }
+
     list->capacity = 0;
     list->size = 0;
 }
@@ -54,17 +153,18 @@ u64 freelist_capacity(freelist* list) {
 
 void freelist_resize(freelist* list, u64 new_size) {
     BX_ASSERT(list != NULL && "Invalid arguments passed to freelist_resize");
+    if (list->chunk_size > 0) return;
 
     if (list->memory == NULL || new_size > list->capacity) {
         u64 new_capacity = (list->capacity == 0) ? 8 : list->capacity;
         while (new_capacity < new_size) new_capacity *= 2;
 
-        void* new_buffer = ballocate(new_capacity, list->tag);
+        void* new_buffer = freelist_allocate_memory(list, new_capacity);
 
         if (list->memory) {
             // copy only the used bytes
             bcopy_memory(new_buffer, list->memory, list->size);
-            bfree(list->memory, list->capacity, list->tag);
+            freelist_free_memory(list);
         }
 
         list->memory = new_buffer;
@@ -76,10 +176,31 @@ void freelist_reset(freelist* list, b8 zero_memory, b8 free_memory) {
     BX_ASSERT(list != NULL && list->memory != NULL && "Invalid arguments passed to freelist_reset");
     list->size = 0;
 
+    if (list->block_offsets) 
+        darray_clear(list->block_offsets);
+
     if (free_memory) {
-        bfree(list->memory, list->capacity, list->tag);
+        if (list->chunk_size > 0) freelist_free_chunks(list);
+        else freelist_free_memory(list);
+
         list->memory = NULL;
         list->capacity = 0;
+
+        if (list->block_offsets) {
+            darray_destroy(list->block_offsets);
+            list->block_offsets = NULL;
+        }
+        return;
+    }
+
+    if (list->chunk_size > 0) {
+        // Keep every chunk for reuse, filling starts over from the first one.
+        for (freelist_chunk* chunk = list->memory; chunk; chunk = chunk->next) {
+            if (zero_memory) bzero_memory((u8*)chunk + sizeof(freelist_chunk), chunk->size - sizeof(freelist_chunk));
+            chunk->used = sizeof(freelist_chunk);
+        }
+
+        list->current_chunk = list->memory;
         return;
     }
 
@@ -88,63 +209,150 @@ void freelist_reset(freelist* list, b8 zero_memory, b8 free_memory) {
     }
 }
 
+void* freelist_push_segmented(freelist* list, u64 block_size, void* memory) {
+    freelist_chunk* chunk = list->current_chunk;
+    u64 payload_pos = freelist_next_payload_offset(list, chunk->used);
+
+    // Blocks must start within the first chunk size bytes of their chunk, only their end may lie past it.
+    if (payload_pos >= list->chunk_size || payload_pos + block_size > chunk->size) {
+        u64 needed = freelist_next_payload_offset(list, sizeof(freelist_chunk)) + block_size;
+
+        // Move on to the next chunk, reusing one kept from before the last reset if it is large enough.
+        // Blocks larger than a chunk get a chunk of their own, placed before any smaller unused ones.
+        freelist_chunk* next = chunk->next;
+        if (!next || next->size < needed)
+            next = freelist_add_chunk(list, chunk, alignment(needed, list->chunk_size));
+
+        chunk = next;
+        if (!chunk) return NULL;
+
+        list->current_chunk = chunk;
+        payload_pos = freelist_next_payload_offset(list, chunk->used);
+    }
+
+    u8* user_ptr = (u8*)chunk + payload_pos;
+    ((freelist_header*)(user_ptr - sizeof(freelist_header)))->payload_size = block_size;
+
+    if (memory != NULL) {
+        bcopy_memory(user_ptr, memory, block_size);
+    }
+
+    if (list->block_offsets) 
+        darray_push(list->block_offsets, (u64)user_ptr);
+
+    list->size += payload_pos + block_size - chunk->used;
+    chunk->used = payload_pos + block_size;
+    return (void*)user_ptr;
+}
+
 void* freelist_push(freelist* list, u64 block_size, void* memory) {
     BX_ASSERT(list != NULL && list->memory != NULL && block_size > 0 && "Invalid arguments passed to freelist_push");
+    if (list->chunk_size > 0) return freelist_push_segmented(list, block_size, memory);
 
-    u64 aligned_pos = alignment(list->size, 8ULL);
-    u64 padding = aligned_pos - list->size;
-
-    u64 required = padding + sizeof(freelist_header) + block_size;
-    freelist_resize(list, list->size + required);
+    // The header sits directly in front of the payload, which starts on the list's alignment.
+    u64 payload_pos = freelist_next_payload_offset(list, list->size);
+    freelist_resize(list, payload_pos + block_size);
 
     if (!list->memory) return NULL;
 
-    u8* internal_block = (u8*)list->memory + aligned_pos;
-    ((freelist_header*)internal_block)->payload_size = block_size;
-
-    u8* user_ptr = internal_block + sizeof(freelist_header);
+    u8* user_ptr = (u8*)list->memory + payload_pos;
+    ((freelist_header*)(user_ptr - sizeof(freelist_header)))->payload_size = block_size;
 
     if (memory != NULL) {
         bcopy_memory(user_ptr, memory, block_size);
     }
 
-    list->size = aligned_pos + sizeof(freelist_header) + block_size;
+    if (list->block_offsets) 
+        darray_push(list->block_offsets, payload_pos);
+
+    list->size = payload_pos + block_size;
     return (void*)user_ptr;
 }
 
 void* freelist_get(freelist* list, u64 index) {
     BX_ASSERT(list != NULL && list->memory != NULL && "Invalid arguments passed to freelist_get");
 
-    u64 pos = 0;
+    if (list->block_offsets) {
+        if (index >= darray_length(list->block_offsets)) return NULL;
+        if (list->chunk_size > 0) return (void*)list->block_offsets[index];
+        return (u8*)list->memory + list->block_offsets[index];
+    }
+
+    if (list->chunk_size > 0) {
+        u8* cursor = 0;
+        for (u64 i = 0; i <= index; ++i) {
+            if (!freelist_next_block(list, &cursor)) return NULL;
+        }
+        return cursor;
+    }
+
+    u64 pos = freelist_next_payload_offset(list, 0);
     for (u64 i = 0; i < index; ++i) {
-        if (pos + sizeof(freelist_header) > list->size) return NULL; // out of range / corrupted
-        freelist_header* hdr = (freelist_header*)((u8*)list->memory + pos);
+        if (pos > list->size) return NULL; // out of range / corrupted
+        freelist_header* hdr = (freelist_header*)((u8*)list->memory + pos - sizeof(freelist_header));
         if (hdr->payload_size > list->capacity) return NULL;
-        pos += sizeof(freelist_header) + hdr->payload_size;
-        pos = alignment(pos, 8ULL);
+        pos = freelist_next_payload_offset(list, pos + hdr->payload_size);
     }
 
-    if (pos + sizeof(freelist_header) > list->size) return NULL;
-    return get_user_memory(list, (u8*)list->memory + pos);
+    if (pos > list->size) return NULL;
+    return (u8*)list->memory + pos;
+}
+
+u64 freelist_block_size(freelist* list, const void* block) {
+    BX_ASSERT(list != NULL && block != NULL && "Invalid arguments passed to freelist_block_size");
+    return ((const freelist_header*)((const u8*)block - sizeof(freelist_header)))->payload_size;
+}
+
+u64 freelist_block_count(freelist* list) {
+    BX_ASSERT(list != NULL && "Invalid arguments passed to freelist_block_count");
+
+    if (list->block_offsets) return darray_length(list->block_offsets);
+    if (!list->memory) return 0;
+
+    u64 count = 0;
+    u8* cursor = 0;
+    while (freelist_next_block(list, &cursor)) ++count;
+    return count;
+}
+
+b8 freelist_next_block_segmented(freelist* list, u8** cursor) {
+    freelist_chunk* chunk = list->memory;
+    u64 end_offset = sizeof(freelist_chunk);
+
+    if (*cursor != 0) {
+        chunk = freelist_chunk_of(list, *cursor);
+        freelist_header* current_hdr = (freelist_header*)(*cursor - sizeof(freelist_header));
+        end_offset = (u64)(*cursor - (u8*)chunk) + current_hdr->payload_size;
+    }
+
+    // Chunks fill in order, the first chunk without blocks ends the list.
+    u64 payload_offset = freelist_next_payload_offset(list, end_offset);
+    while (payload_offset > chunk->used) {
+        chunk = chunk->next;
+        if (!chunk || chunk->used == sizeof(freelist_chunk)) return FALSE;
+        payload_offset = freelist_next_payload_offset(list, sizeof(freelist_chunk));
+    }
+
+    *cursor = (u8*)chunk + payload_offset;
+    return TRUE;
 }
 
 b8 freelist_next_block(freelist* list, u8** cursor) {
     BX_ASSERT(list != NULL && cursor != NULL && list->memory != NULL && "Invalid arguments passed to freelist_next_block");
-    u8* next_block_header = 0;
+    if (list->chunk_size > 0) return freelist_next_block_segmented(list, cursor);
 
-    if (*cursor == 0) {
-        next_block_header = list->memory;
-    }
-    else {
+    u64 end_offset = 0;
+
+    if (*cursor != 0) {
         freelist_header* current_hdr = (freelist_header*)(*cursor - sizeof(freelist_header));
-        next_block_header = *cursor + current_hdr->payload_size;
+        end_offset = (u64)(*cursor - (u8*)list->memory) + current_hdr->payload_size;
     }
 
-    u64 memory_limit = (u64)list->memory + list->size;
-    if ((u64)next_block_header + sizeof(freelist_header) > memory_limit) {
+    u64 payload_offset = freelist_next_payload_offset(list, end_offset);
+    if (payload_offset > list->size) {
         return FALSE;
     }
 
-    *cursor = (u8*)alignment((u64)next_block_header + sizeof(freelist_header), 8ULL);
+    *cursor = (u8*)list->memory + payload_offset;
     return TRUE;
-}
\ No newline at end of file
+}
@@ -3,23 +3,48 @@
 #include "defines.h"
 
 // A data structure to be used for dynamic memory allocation. Tracks free ranges of memory.
+// Contiguous lists keep every block in one buffer that is regrown (and moved) as needed.
+// Segmented lists keep blocks in fixed size chunks that are never moved, so pointers stay valid until reset.
 typedef struct freelist {
-    // The internal memory of the freelist.
+    // The internal memory of the freelist, the first chunk of a segmented list.
     void* memory;
 
     // Number of bytes allocated by freelist.
     u64 capacity;
 
+    // Size in bytes of each chunk of a segmented list, 0 for contiguous lists.
+    u64 chunk_size;
+
+    // Chunk currently being filled by a segmented list.
+    void* current_chunk;
+
     // Size of region used by freelist within managed buffer.
     u64 size;
 
+    // Alignment in bytes of every block returned by the freelist.
+    u64 alignment;
+
     // Memory tag of internal memory in freelist.
     memory_tag tag;
+
+    // Optional darray of payload offsets (addresses for segmented lists), one per block,
+    // filled by freelist_push so freelist_get is O(1). NULL unless freelist_enable_index was called.
+    u64* block_offsets;
 } freelist;
 
 // Creates a new freelist.
 void freelist_create(u64 start_size, memory_tag tag, freelist* out_list);
 
+// Creates a new freelist where every block starts on a boundary of 'alignment' bytes (must be a power of two, at least 8).
+void freelist_create_aligned(u64 start_size, u64 alignment, memory_tag tag, freelist* out_list);
+
+// Creates a new segmented freelist made of chunks of 'chunk_size' bytes (a power of two).
+// Chunks are kept across resets, blocks larger than a chunk get a chunk of their own rounded up to a multiple of 'chunk_size'.
+void freelist_create_segmented(u64 chunk_size, memory_tag tag, freelist* out_list);
+
+// Keeps an offset per block from now on so blocks can be accessed by index in O(1). Existing blocks are indexed immediately.
+void freelist_enable_index(freelist* list);
+
 // Safely checks if data at pointer is freelist or is freelist and capacity == 0.
 b8 freelist_empty(freelist* list);
 
@@ -32,17 +57,24 @@ u64 freelist_size(freelist* list);
 // Gets number of bytes allocated by freelist.
 u64 freelist_capacity(freelist* list);
 
-// Resizes freelist to size and cuts off memory if new size is smaller than current size.
+// Resizes freelist to size and cuts off memory if new size is smaller than current size. Segmented lists grow by chunk on push instead.
 void freelist_resize(freelist* list, u64 new_size);
 
-// Resets freelist for reusing memory within.
+// Resets freelist for reusing memory within. Freeing the memory also drops the block index.
 void freelist_reset(freelist* list, b8 zero_memory, b8 free_memory);
 
 // Pushes free range of memory onto list.
 void* freelist_push(freelist* list, u64 block_size, void* memory);
 
-// Gets index'th block and returns pointer, use sparingly or use freelist_next_block.
+// Gets index'th block and returns pointer. O(1) on indexed lists, otherwise walks every block before it.
+// On indexed lists a sub-range can be handed out by starting freelist_next_block at freelist_get(list, first).
 void* freelist_get(freelist* list, u64 index);
 
+// Gets size in bytes of a block returned by the list, as it was pushed.
+u64 freelist_block_size(freelist* list, const void* block);
+
+// Gets number of blocks pushed since the last reset. O(1) on indexed lists.
+u64 freelist_block_count(freelist* list);
+
 // Used for iteration and while loop.
 b8 freelist_next_block(freelist* list, u8** cursor);
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "defines.h"
+#include "radix_sort.h"
+
+void radix_sort_by_key(void* records, void* scratch, u64 count, u64 stride) {
+    BX_ASSERT(((records != NULL && scratch != NULL) || count == 0) && stride >= sizeof(u64) && stride % sizeof(u64) == 0 && "Invalid arguments passed to radix_sort_by_key");
+    if (count < 2) return;
+
+    u8* src = (u8*)records;
+    u8* dst = (u8*)scratch;
+
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        u64 offsets[256] = {};
+        for (u64 i = 0; i < count; ++i)
+            offsets[(*(u64*)(src + i * stride) >> shift) & 0xFF]++;
+
+        // Every key has the same byte here, this pass would not move anything.
+        if (offsets[(*(u64*)src >> shift) & 0xFF] == count) continue;
+
+        u64 total = 0;
+        for (u32 digit = 0; digit < 256; ++digit) {
+            u64 digit_count = offsets[digit];
+            offsets[digit] = total;
+            total += digit_count;
+        }
+
+        for (u64 i = 0; i < count; ++i) {
+            u8* record = src + i * stride;
+            bcopy_memory(dst + offsets[(*(u64*)record >> shift) & 0xFF]++ * stride, record, stride);
+        }
+
+        u8* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != (u8*)records)
+        bcopy_memory(records, src, count * stride);
+}
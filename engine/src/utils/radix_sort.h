@@ -0,0 +1,8 @@
+#pragma once
+
+#include "defines.h"
+
+// Stable LSD radix sort of 'count' records of 'stride' bytes, ordered by the u64 key at the start of each record.
+// 'scratch' must hold 'count' records as well. 'stride' must be a multiple of 8.
+// Byte positions where every key is equal are skipped, so keys using few distinct bits sort in fewer passes.
+void radix_sort_by_key(void* records, void* scratch, u64 count, u64 stride);
@@ -0,0 +1,259 @@
+#include "defines.h"
+#include "range_allocator.h"
+
+#include "utils/darray.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+
+static inline i32 range_ffs(u64 word) {
+    unsigned long index;
+    return _BitScanForward64(&index, word) ? (i32)index : -1;
+}
+
+static inline i32 range_fls(u64 word) {
+    unsigned long index;
+    return _BitScanReverse64(&index, word) ? (i32)index : -1;
+}
+#else
+static inline i32 range_ffs(u64 word) {
+    return word ? __builtin_ctzll(word) : -1;
+}
+
+static inline i32 range_fls(u64 word) {
+    return word ? 63 - __builtin_clzll(word) : -1;
+}
+#endif
+
+// Maps a range size to the bin it is stored in. Sizes below RANGE_ALLOCATOR_SL_COUNT get a bin each.
+static void range_mapping_insert(u64 size, i32* fl, i32* sl) {
+    if (size < RANGE_ALLOCATOR_SL_COUNT) {
+        *fl = 0;
+        *sl = (i32)size;
+        return;
+    }
+
+    i32 first = range_fls(size);
+    *sl = (i32)(size >> (first - RANGE_ALLOCATOR_SL_COUNT_LOG2)) ^ RANGE_ALLOCATOR_SL_COUNT;
+    *fl = first - RANGE_ALLOCATOR_SL_COUNT_LOG2 + 1;
+}
+
+// Maps a requested size to the first bin whose ranges are all guaranteed to be large enough.
+static void range_mapping_search(u64 size, i32* fl, i32* sl) {
+    if (size >= RANGE_ALLOCATOR_SL_COUNT)
+        size += (1ULL << (range_fls(size) - RANGE_ALLOCATOR_SL_COUNT_LOG2)) - 1;
+
+    range_mapping_insert(size, fl, sl);
+}
+
+static u32 range_node_acquire(range_allocator* allocator) {
+    if (darray_length(allocator->unused_nodes) > 0) {
+        u32 index = 0;
+        darray_pop(allocator->unused_nodes, &index);
+        return index;
+    }
+
+    darray_push_empty(allocator->nodes);
+    return (u32)darray_length(allocator->nodes) - 1;
+}
+
+static void range_node_release(range_allocator* allocator, u32 index) {
+    darray_push(allocator->unused_nodes, index);
+}
+
+static void range_bin_insert(range_allocator* allocator, u32 index) {
+    range_node* node = &allocator->nodes[index];
+
+    i32 fl, sl;
+    range_mapping_insert(node->size, &fl, &sl);
+
+    u32 head = allocator->bins[fl][sl];
+    node->bin_prev = RANGE_ALLOCATOR_NONE;
+    node->bin_next = head;
+    if (head != RANGE_ALLOCATOR_NONE) allocator->nodes[head].bin_prev = index;
+
+    allocator->bins[fl][sl] = index;
+    allocator->fl_bitmap |= 1ULL << fl;
+    allocator->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void range_bin_remove(range_allocator* allocator, u32 index) {
+    range_node* node = &allocator->nodes[index];
+
+    i32 fl, sl;
+    range_mapping_insert(node->size, &fl, &sl);
+
+    if (node->bin_prev != RANGE_ALLOCATOR_NONE) allocator->nodes[node->bin_prev].bin_next = node->bin_next;
+    if (node->bin_next != RANGE_ALLOCATOR_NONE) allocator->nodes[node->bin_next].bin_prev = node->bin_prev;
+
+    if (allocator->bins[fl][sl] == index) {
+        allocator->bins[fl][sl] = node->bin_next;
+
+        if (node->bin_next == RANGE_ALLOCATOR_NONE) {
+            allocator->sl_bitmap[fl] &= ~(1U << sl);
+            if (!allocator->sl_bitmap[fl]) allocator->fl_bitmap &= ~(1ULL << fl);
+        }
+    }
+}
+
+static u32 range_search_suitable(range_allocator* allocator, i32 fl, i32 sl) {
+    if (fl >= RANGE_ALLOCATOR_FL_COUNT) return RANGE_ALLOCATOR_NONE;
+
+    u32 sl_map = allocator->sl_bitmap[fl] & (~0U << sl);
+    if (!sl_map) {
+        // No range in this first-level class, look in the next non-empty larger one.
+        u64 fl_map = fl + 1 < 64 ? allocator->fl_bitmap & (~0ULL << (fl + 1)) : 0;
+        if (!fl_map) return RANGE_ALLOCATOR_NONE;
+
+        fl = range_ffs(fl_map);
+        sl_map = allocator->sl_bitmap[fl];
+    }
+
+    return allocator->bins[fl][range_ffs(sl_map)];
+}
+
+// Splits a new free node of 'size' bytes off 'index' and links it in front of or behind it.
+static void range_split_free(range_allocator* allocator, u32 index, u64 size, b8 in_front) {
+    u32 split = range_node_acquire(allocator);
+    range_node* node = &allocator->nodes[index];
+    range_node* free_node = &allocator->nodes[split];
+
+    free_node->size = size;
+    free_node->used = FALSE;
+    node->size -= size;
+
+    if (in_front) {
+        free_node->offset = node->offset;
+        node->offset += size;
+
+        free_node->neighbor_prev = node->neighbor_prev;
+        free_node->neighbor_next = index;
+        if (node->neighbor_prev != RANGE_ALLOCATOR_NONE) allocator->nodes[node->neighbor_prev].neighbor_next = split;
+        node->neighbor_prev = split;
+    }
+    else {
+        free_node->offset = node->offset + node->size;
+
+        free_node->neighbor_prev = index;
+        free_node->neighbor_next = node->neighbor_next;
+        if (node->neighbor_next != RANGE_ALLOCATOR_NONE) allocator->nodes[node->neighbor_next].neighbor_prev = split;
+        node->neighbor_next = split;
+    }
+
+    range_bin_insert(allocator, split);
+}
+
+b8 range_allocator_create(u64 size, memory_tag tag, range_allocator* out_allocator) {
+    BX_ASSERT(size > 0 && out_allocator != NULL && "Invalid arguments passed to range_allocator_create");
+
+    bzero_memory(out_allocator, sizeof(range_allocator));
+    bset_memory(out_allocator->bins, 0xFF, sizeof(out_allocator->bins));
+    out_allocator->size = size;
+    out_allocator->free_size = size;
+    out_allocator->nodes = darray_create(range_node, tag);
+    out_allocator->unused_nodes = darray_create(u32, tag);
+
+    u32 index = range_node_acquire(out_allocator);
+    range_node* node = &out_allocator->nodes[index];
+    node->offset = 0;
+    node->size = size;
+    node->used = FALSE;
+    node->neighbor_prev = RANGE_ALLOCATOR_NONE;
+    node->neighbor_next = RANGE_ALLOCATOR_NONE;
+
+    range_bin_insert(out_allocator, index);
+    return TRUE;
+}
+
+void range_allocator_destroy(range_allocator* allocator) {
+    BX_ASSERT(allocator != NULL && "Invalid arguments passed to range_allocator_destroy");
+
+    if (allocator->nodes) darray_destroy(allocator->nodes);
+    if (allocator->unused_nodes) darray_destroy(allocator->unused_nodes);
+    bzero_memory(allocator, sizeof(range_allocator));
+}
+
+b8 range_allocator_allocate(range_allocator* allocator, u64 size, u64 align, range_allocation* out_allocation) {
+    BX_ASSERT(allocator != NULL && size > 0 && align > 0 && (align & (align - 1)) == 0 && out_allocation != NULL && "Invalid arguments passed to range_allocator_allocate");
+
+    // Searching for the worst case padding guarantees any range found can be aligned.
+    i32 fl, sl;
+    range_mapping_search(size + align - 1, &fl, &sl);
+
+    u32 index = range_search_suitable(allocator, fl, sl);
+    if (index == RANGE_ALLOCATOR_NONE) return FALSE;
+
+    range_bin_remove(allocator, index);
+
+    // Neighbours of a free range are always used, so split off parts need no merging.
+    u64 padding = alignment(allocator->nodes[index].offset, align) - allocator->nodes[index].offset;
+    if (padding > 0) range_split_free(allocator, index, padding, TRUE);
+    if (allocator->nodes[index].size > size) range_split_free(allocator, index, allocator->nodes[index].size - size, FALSE);
+
+    range_node* node = &allocator->nodes[index];
+    node->used = TRUE;
+    allocator->free_size -= node->size;
+
+    out_allocation->offset = node->offset;
+    out_allocation->size = node->size;
+    out_allocation->node = index;
+    return TRUE;
+}
+
+void range_allocator_free(range_allocator* allocator, range_allocation* allocation) {
+    BX_ASSERT(allocator != NULL && allocation != NULL && allocation->node < darray_length(allocator->nodes) && "Invalid arguments passed to range_allocator_free");
+
+    u32 index = allocation->node;
+    range_node* node = &allocator->nodes[index];
+    BX_ASSERT(node->used && node->offset == allocation->offset && "Range freed twice or does not belong to this allocator");
+
+    node->used = FALSE;
+    allocator->free_size += node->size;
+
+    // Absorb the free neighbour in front.
+    u32 prev = node->neighbor_prev;
+    if (prev != RANGE_ALLOCATOR_NONE && !allocator->nodes[prev].used) {
+        range_node* prev_node = &allocator->nodes[prev];
+        range_bin_remove(allocator, prev);
+
+        node->offset = prev_node->offset;
+        node->size += prev_node->size;
+        node->neighbor_prev = prev_node->neighbor_prev;
+        if (node->neighbor_prev != RANGE_ALLOCATOR_NONE) allocator->nodes[node->neighbor_prev].neighbor_next = index;
+
+        range_node_release(allocator, prev);
+    }
+
+    // Absorb the free neighbour behind.
+    u32 next = node->neighbor_next;
+    if (next != RANGE_ALLOCATOR_NONE && !allocator->nodes[next].used) {
+        range_node* next_node = &allocator->nodes[next];
+        range_bin_remove(allocator, next);
+
+        node->size += next_node->size;
+        node->neighbor_next = next_node->neighbor_next;
+        if (node->neighbor_next != RANGE_ALLOCATOR_NONE) allocator->nodes[node->neighbor_next].neighbor_prev = index;
+
+        range_node_release(allocator, next);
+    }
+
+    range_bin_insert(allocator, index);
+    allocation->node = RANGE_ALLOCATOR_NONE;
+}
+
+void range_allocator_get_stats(range_allocator* allocator, range_allocator_stats* out_stats) {
+    BX_ASSERT(allocator != NULL && out_stats != NULL && "Invalid arguments passed to range_allocator_get_stats");
+    bzero_memory(out_stats, sizeof(range_allocator_stats));
+
+    out_stats->used_bytes = allocator->size - allocator->free_size;
+    out_stats->free_bytes = allocator->free_size;
+
+    for (u32 fl = 0; fl < RANGE_ALLOCATOR_FL_COUNT; ++fl) {
+        for (u32 sl = 0; sl < RANGE_ALLOCATOR_SL_COUNT; ++sl) {
+            for (u32 index = allocator->bins[fl][sl]; index != RANGE_ALLOCATOR_NONE; index = allocator->nodes[index].bin_next) {
+                out_stats->free_range_count++;
+                out_stats->largest_free_range = BX_MAX(out_stats->largest_free_range, allocator->nodes[index].size);
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "defines.h"
+
+// log2 of the number of second-level bins per first-level size class.
+#define RANGE_ALLOCATOR_SL_COUNT_LOG2 4
+#define RANGE_ALLOCATOR_SL_COUNT (1 << RANGE_ALLOCATOR_SL_COUNT_LOG2)
+
+// First-level classes cover every power of two up to 2^63.
+#define RANGE_ALLOCATOR_FL_COUNT (64 - RANGE_ALLOCATOR_SL_COUNT_LOG2 + 1)
+
+// Marks the absence of a node in the node links.
+#define RANGE_ALLOCATOR_NONE 0xFFFFFFFFU
+
+// A range within the managed space, either handed out or free.
+typedef struct range_node {
+    u64 offset;
+    u64 size;
+
+    // Links within the bin of free nodes of the same size class.
+    u32 bin_prev, bin_next;
+
+    // Links to the nodes directly before and after this one in the managed space.
+    u32 neighbor_prev, neighbor_next;
+
+    b8 used;
+} range_node;
+
+// A range handed out by range_allocator_allocate.
+typedef struct range_allocation {
+    u64 offset;
+    u64 size;
+
+    // Node backing this allocation, needed to free it.
+    u32 node;
+} range_allocation;
+
+// Usage and fragmentation statistics of a range allocator.
+typedef struct range_allocator_stats {
+    u64 used_bytes;
+    u64 free_bytes;
+    u64 free_range_count;
+    u64 largest_free_range;
+} range_allocator_stats;
+
+// Two-Level Segregated Fit allocator over a range of offsets, with no memory behind it.
+// Used to suballocate resources that live elsewhere, such as VkDeviceMemory blocks or large VkBuffers.
+// Allocation and free run in O(1), neighbouring free ranges are coalesced on free.
+typedef struct range_allocator {
+    // Total size of the managed range in bytes.
+    u64 size;
+
+    // Bytes not handed out.
+    u64 free_size;
+
+    // Bitmap of first-level classes that contain at least one free range.
+    u64 fl_bitmap;
+
+    // Bitmaps of second-level bins that contain at least one free range, per first-level class.
+    u32 sl_bitmap[RANGE_ALLOCATOR_FL_COUNT];
+
+    // Head node of each bin.
+    u32 bins[RANGE_ALLOCATOR_FL_COUNT][RANGE_ALLOCATOR_SL_COUNT];
+
+    // darray of every node, indices stay valid as it grows.
+    range_node* nodes;
+
+    // darray of node indices available for reuse.
+    u32* unused_nodes;
+} range_allocator;
+
+// Creates an allocator managing offsets [0, size).
+b8 range_allocator_create(u64 size, memory_tag tag, range_allocator* out_allocator);
+
+void range_allocator_destroy(range_allocator* allocator);
+
+// Finds a free range of 'size' bytes starting on a multiple of 'align' (a power of two). Returns FALSE if none fits.
+b8 range_allocator_allocate(range_allocator* allocator, u64 size, u64 align, range_allocation* out_allocation);
+
+// Returns a range to the allocator, merging it with free neighbours.
+void range_allocator_free(range_allocator* allocator, range_allocation* allocation);
+
+// Walks the bins and fills out usage and fragmentation statistics.
+void range_allocator_get_stats(range_allocator* allocator, range_allocator_stats* out_stats);
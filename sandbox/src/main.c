@@ -13,6 +13,12 @@ box_shader_src read_file(const char* p) {
 }
 
 int main(int argc, char** argv) {
+	memory_config memory_config = memory_default_config();
+	if (!memory_init(&memory_config)) {
+        printf("Failed to initialize memory system\n");
+        return -1;
+	}
+
 	box_window_config window_config = box_window_default_config();
 	window_config.window_size = (uvec2) { 640, 640 };
 	window_config.title = "Test Window";
@@ -126,10 +132,21 @@ int main(int argc, char** argv) {
 
 	show_memory_stats();
 
+	// The scene never changes, so its draws are recorded once and the backend keeps their translation.
+	box_rendercmd scene_bundle = {};
+	box_rendercmd_begin_static(&scene_bundle, &backend.main_rendertarget);
+	box_rendercmd_begin_renderstage(&scene_bundle, &renderstage);
+	box_rendercmd_draw_indexed(&scene_bundle, 6, 1);
+	box_rendercmd_end_renderstage(&scene_bundle);
+	box_rendercmd_end(&scene_bundle);
+
+	box_rendercmd* bundles[] = { &scene_bundle };
+
 	box_rendercmd rendercmd = {};
 	box_rendercmd_context submit_context = {};
 
 	f64 last_time = platform_get_absolute_time();
+	f64 stats_timer = 0.0;
 	while (!platform_should_close_window(&platform)) {
         f64 now = platform_get_absolute_time();
         f64 delta_time = now - last_time;
@@ -141,9 +158,7 @@ int main(int argc, char** argv) {
 			// ------------------
 			box_rendercmd_begin(&rendercmd);
 			box_rendercmd_bind_rendertarget(&rendercmd, &backend.main_rendertarget);
-			box_rendercmd_begin_renderstage(&rendercmd, &renderstage);
-			box_rendercmd_draw_indexed(&rendercmd, 6, 1);
-			box_rendercmd_end_renderstage(&rendercmd);
+			box_rendercmd_execute_secondary(&rendercmd, bundles, BX_ARRAYSIZE(bundles));
 			box_rendercmd_end(&rendercmd);
 			
 			// ------------------
@@ -159,10 +174,26 @@ int main(int argc, char** argv) {
 			}
 		}
 
+		memory_frame_mark();
+
+		// Log allocation churn of the last frame about once a second, if the engine keeps counters.
+		stats_timer += delta_time;
+		if (stats_timer >= 1.0) {
+			memory_stats stats = {};
+			memory_get_stats(&stats);
+			if (stats.diagnostics_enabled) {
+				printf("Frame %llu: %llu allocs (%llu bytes), %llu frees (%llu bytes), %llu bytes live (peak %llu)\n",
+					stats.frame_index, stats.total.frame_allocation_count, stats.total.frame_allocated_bytes,
+					stats.total.frame_free_count, stats.total.frame_freed_bytes, stats.total.current_bytes, stats.total.peak_bytes);
+			}
+			stats_timer = 0.0;
+		}
+
 		platform_pump_messages(&platform);
 	}
 
 	box_rendercmd_destroy(&rendercmd);
+	box_rendercmd_destroy(&scene_bundle);
 
 failed_init:
 	backend.destroy_renderstage(&backend, &renderstage);
@@ -0,0 +1,121 @@
+#include "test.h"
+
+#include "core/memory.h"
+#include "utils/range_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPACE_SIZE (1 << 20)
+#define MAX_LIVE 2048
+#define ITERATIONS 200000
+
+// Reference ownership map, the id of the live allocation covering each byte or 0 if free.
+static u16 owners[SPACE_SIZE];
+
+typedef struct live_range {
+    range_allocation allocation;
+    u16 id;
+} live_range;
+
+static live_range live[MAX_LIVE];
+
+// Percentage of free space that can not be handed out as a single range.
+f64 fragmentation(range_allocator_stats* stats) {
+    return stats->free_bytes > 0 ? 100.0 * (1.0 - (f64)stats->largest_free_range / (f64)stats->free_bytes) : 0.0;
+}
+
+int check_stats(range_allocator* allocator, u64 expected_used) {
+    range_allocator_stats stats = {};
+    range_allocator_get_stats(allocator, &stats);
+
+    TEST_CHECK(stats.used_bytes == expected_used);
+    TEST_CHECK(stats.used_bytes + stats.free_bytes == SPACE_SIZE);
+    TEST_CHECK(stats.largest_free_range <= stats.free_bytes);
+    return 0;
+}
+
+int main() {
+    memory_config config = memory_default_config();
+    if (!memory_init(&config)) return 1;
+
+    range_allocator allocator = {};
+    TEST_CHECK(range_allocator_create(SPACE_SIZE, MEMORY_TAG_CORE, &allocator));
+
+    srand(1);
+    u32 live_count = 0;
+    u64 used = 0;
+    u16 next_id = 1;
+    u32 failed_allocations = 0;
+    f64 peak_fragmentation = 0.0;
+
+    for (u32 i = 0; i < ITERATIONS; ++i) {
+        if (live_count < MAX_LIVE && (live_count == 0 || rand() % 2)) {
+            // Mostly small ranges with the occasional large one, at alignments from 1 to 256 bytes.
+            u64 size = 1 + rand() % (rand() % 4 == 0 ? 20000 : 300);
+            u64 align = 1ULL << (rand() % 9);
+
+            range_allocation allocation = {};
+            if (!range_allocator_allocate(&allocator, size, align, &allocation)) {
+                ++failed_allocations;
+                continue;
+            }
+
+            TEST_CHECK(allocation.size == size && allocation.offset % align == 0);
+            TEST_CHECK(allocation.offset + allocation.size <= SPACE_SIZE);
+
+            u16 id = next_id++;
+            if (next_id == 0) next_id = 1;
+
+            for (u64 j = 0; j < size; ++j) {
+                TEST_CHECK(owners[allocation.offset + j] == 0);
+                owners[allocation.offset + j] = id;
+            }
+
+            live[live_count++] = (live_range) { allocation, id };
+            used += size;
+        }
+        else {
+            u32 index = rand() % live_count;
+            live_range range = live[index];
+            live[index] = live[--live_count];
+
+            // Nothing else may have written into the range while it was live.
+            for (u64 j = 0; j < range.allocation.size; ++j)
+                TEST_CHECK(owners[range.allocation.offset + j] == range.id);
+
+            memset(&owners[range.allocation.offset], 0, range.allocation.size * sizeof(u16));
+            range_allocator_free(&allocator, &range.allocation);
+            used -= range.allocation.size;
+        }
+
+        if (i % 1000 == 0) {
+            if (check_stats(&allocator, used)) return 1;
+
+            range_allocator_stats stats = {};
+            range_allocator_get_stats(&allocator, &stats);
+            f64 current = fragmentation(&stats);
+            if (current > peak_fragmentation) peak_fragmentation = current;
+        }
+    }
+
+    range_allocator_stats stats = {};
+    range_allocator_get_stats(&allocator, &stats);
+    printf("After %u operations: %u live ranges, %llu bytes used, %llu free in %llu ranges (largest %llu), %.2f%% fragmented (peak %.2f%%), %u failed allocations\n",
+        ITERATIONS, live_count, stats.used_bytes, stats.free_bytes, stats.free_range_count, stats.largest_free_range,
+        fragmentation(&stats), peak_fragmentation, failed_allocations);
+
+    // Freeing everything must coalesce back into a single range covering the whole space.
+    while (live_count > 0) {
+        live_range range = live[--live_count];
+        range_allocator_free(&allocator, &range.allocation);
+    }
+
+    range_allocator_get_stats(&allocator, &stats);
+    TEST_CHECK(stats.used_bytes == 0);
+    TEST_CHECK(stats.free_range_count == 1 && stats.largest_free_range == SPACE_SIZE);
+
+    range_allocator_destroy(&allocator);
+    memory_shutdown();
+    return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "defines.h"
+
+#include <stdio.h>
+
+// Fails the enclosing test, which returns an int, with the location of the broken expectation.
+#define TEST_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: Check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)